@@ -0,0 +1,88 @@
+#include "IconAtlas.h"
+#include <SdCache.h>
+
+const char IconAtlas::PATH[] = "/icons.atl";
+
+bool IconAtlas::find(const char *name, Entry &icon) {
+  File file;
+  if (!SdCache::open(file, PATH)) {
+    return false;
+  }
+
+  uint32_t key = hash(name);
+  bool found = false;
+  Header header;
+  if (file.read(&header, sizeof(header)) == sizeof(header) &&
+      memcmp_P(header.magic, PSTR("ICNA"), sizeof(header.magic)) == 0 && header.version == VERSION) {
+    uint16_t low = 0;
+    uint16_t high = header.count;
+    while (low < high) { // Binary search of the table
+      uint16_t mid = (low + high) / 2;
+      file.seekSet(sizeof(Header) + (uint32_t)mid * sizeof(Entry));
+      if (file.read(&icon, sizeof(icon)) != sizeof(icon)) {
+        break;
+      }
+      if (icon.hash < key) {
+        low = mid + 1;
+      } else if (icon.hash > key) {
+        high = mid;
+      } else {
+        found = true;
+        break;
+      }
+    }
+  }
+  file.close();
+  return found;
+}
+
+bool IconAtlas::draw(Adafruit_SPITFT *tft, const Entry &icon, int16_t x, int16_t y) {
+  if (x < 0 || y < 0 || x + icon.w > tft->width() || y + icon.h > tft->height()) {
+    return false;
+  }
+  File file;
+  if (!SdCache::open(file, PATH) || !file.seekSet(icon.offset)) {
+    file.close();
+    return false;
+  }
+
+  uint16_t buf[BUFFER_PIXELS];
+  uint16_t pixels = icon.w * icon.h;
+  tft->startWrite();
+  tft->setAddrWindow(x, y, icon.w, icon.h);
+  while (pixels > 0) {
+    // The SD card shares the SPI bus, the address window is kept between blocks
+    tft->endWrite();
+    uint16_t size = icon.flags & RLE ? sizeof(buf) : (pixels < BUFFER_PIXELS ? pixels : BUFFER_PIXELS) * 2;
+    int bytes = file.read(buf, size);
+    tft->startWrite();
+    if (bytes <= 0) {
+      break;
+    }
+
+    if (icon.flags & RLE) {
+      const uint8_t *run = (const uint8_t*)buf;
+      for (int i = 0; i + 2 < bytes && pixels > 0; i += 3) {
+        uint16_t count = min(run[i] + 1, pixels);
+        tft->writeColor(run[i + 1] | (run[i + 2] << 8), count);
+        pixels -= count;
+      }
+    } else {
+      tft->writePixels(buf, bytes / 2);
+      pixels -= bytes / 2;
+    }
+  }
+  tft->endWrite();
+  file.close();
+  return pixels == 0;
+}
+
+uint32_t IconAtlas::hash(const char *name) {
+  char lower[32];
+  uint8_t i = 0;
+  for (; name[i] != '\0' && i < sizeof(lower) - 1; i++) {
+    lower[i] = tolower(name[i]);
+  }
+  lower[i] = '\0';
+  return SdCache::hash(lower);
+}
@@ -0,0 +1,80 @@
+#ifndef ICON_ATLAS_H
+#define ICON_ATLAS_H
+
+#include <Arduino.h>
+#include <Adafruit_SPITFT.h>
+
+/**
+ * @brief Icons pre-converted to RGB565 and packed into `/icons.atl` by `tools/compile_icons.py`
+ * A table of icons sorted by name hash is followed by their pixels, raw or run length encoded. An icon is drawn
+ * with one seek and its pixels are written into an address window in blocks, without converting them
+ */
+class IconAtlas {
+  public:
+    /**
+     * @brief Icon flag, pixels are runs of a count less 1 then a colour
+     */
+    static const uint8_t RLE = 0x01;
+    /**
+     * @brief An icon table record
+     */
+    struct Entry {
+      uint32_t hash; // Of the icon name, see `hash()`
+      uint32_t offset; // Of the pixels in the atlas, 0 if not in it
+      uint8_t w;
+      uint8_t h;
+      uint8_t flags;
+      uint8_t padding;
+    };
+    /**
+     * @brief Find an icon in the atlas
+     * 
+     * @param name Icon name, the BMP name without `.bmp`
+     * @param icon 
+     * @return true 
+     * @return false There's no atlas or the icon isn't in it
+     */
+    static bool find(const char *name, Entry &icon);
+    /**
+     * @brief Draw an icon
+     * 
+     * @param tft 
+     * @param icon From `find()`
+     * @param x 
+     * @param y 
+     * @return true 
+     * @return false It's off the screen or the atlas couldn't be read
+     */
+    static bool draw(Adafruit_SPITFT *tft, const Entry &icon, int16_t x, int16_t y);
+    /**
+     * @brief Hash of an icon name, ignoring case as the BMPs are looked up on FAT
+     * 
+     * @param name 
+     * @return uint32_t 
+     */
+    static uint32_t hash(const char *name);
+  private:
+    /**
+     * @brief Atlas file header
+     */
+    struct Header {
+      char magic[4];
+      uint8_t version;
+      uint8_t padding;
+      uint16_t count; // Icons in the table
+    };
+    /**
+     * @brief Atlas file
+     */
+    static const char PATH[];
+    /**
+     * @brief Format version, a different version isn't read
+     */
+    static const uint8_t VERSION = 1;
+    /**
+     * @brief Pixels read at a time, a whole number of runs too
+     */
+    static const uint8_t BUFFER_PIXELS = 96;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "SdCache.h"
+
+SdFat *SdCache::_sd = nullptr;
+SdCache::Dir SdCache::_dirs[SdCache::MAX_DIRS];
+uint8_t SdCache::_nextDir = 0;
+SdCache::Entry SdCache::_entries[SdCache::MAX_ENTRIES] = { };
+uint16_t SdCache::_hits = 0;
+uint16_t SdCache::_misses = 0;
+
+void SdCache::begin(SdFat *sd) {
+  _sd = sd;
+}
+
+bool SdCache::open(FatFile &file, const char *path) {
+  const char *name = strrchr(path, '/');
+  if (name == nullptr) { // Relative paths aren't cached
+    return file.open(_sd->vwd(), path, O_READ);
+  }
+  name++;
+
+  uint32_t key = hash(path);
+  for (uint8_t i = 0; i < MAX_ENTRIES && _entries[i].hash != 0; i++) {
+    if (_entries[i].hash == key) {
+      Entry entry = _entries[i];
+      remove(i);
+
+      // Check it's still the same file, it may have been removed or renamed
+      char buf[32];
+      if (file.open(&_dirs[entry.dir].file, entry.index, O_READ) &&
+          file.getName(buf, sizeof(buf)) && strcasecmp(buf, name) == 0) {
+        add(key, entry.dir, entry.index);
+        _hits++;
+        return true;
+      }
+      file.close();
+      break;
+    }
+  }
+
+  _misses++;
+  uint8_t dir = openDir(path, name - path - 1);
+  if (dir == MAX_DIRS) {
+    return file.open(_sd->vwd(), path, O_READ);
+  }
+  if (!file.open(&_dirs[dir].file, name, O_READ)) {
+    return false;
+  }
+  add(key, dir, file.dirIndex());
+  return true;
+}
+
+bool SdCache::exists(const char *path) {
+  FatFile file;
+  bool exists = open(file, path);
+  file.close();
+  return exists;
+}
+
+uint32_t SdCache::hash(const char *path) {
+  uint32_t hash = 2166136261UL;
+  for (; *path != '\0'; path++) {
+    hash = (hash ^ (uint8_t)*path) * 16777619UL;
+  }
+  return hash != 0 ? hash : 1; // 0 marks an unused slot
+}
+
+uint16_t SdCache::getHits() {
+  return _hits;
+}
+
+uint16_t SdCache::getMisses() {
+  return _misses;
+}
+
+uint8_t SdCache::openDir(const char *path, uint8_t length) {
+  char dirPath[24];
+  if (length >= sizeof(dirPath)) {
+    return MAX_DIRS;
+  }
+  memcpy(dirPath, path, length);
+  dirPath[length] = '\0';
+
+  uint32_t key = hash(dirPath);
+  for (uint8_t i = 0; i < MAX_DIRS; i++) {
+    if (_dirs[i].hash == key) {
+      return i;
+    }
+  }
+
+  // Replace the next directory in turn, dropping the paths cached in it
+  uint8_t dir = _nextDir;
+  _nextDir = (_nextDir + 1) % MAX_DIRS;
+  for (uint8_t i = 0; i < MAX_ENTRIES && _entries[i].hash != 0;) {
+    if (_entries[i].dir == dir) {
+      remove(i);
+    } else {
+      i++;
+    }
+  }
+  _dirs[dir].file.close();
+  _dirs[dir].hash = 0;
+
+  bool opened = length == 0 ? _dirs[dir].file.openRoot(_sd) : _dirs[dir].file.open(_sd->vwd(), dirPath, O_READ);
+  if (!opened) {
+    return MAX_DIRS;
+  }
+  _dirs[dir].hash = key;
+  return dir;
+}
+
+void SdCache::add(uint32_t hash, uint8_t dir, uint16_t index) {
+  // Shift down, the least recently used falls off the end
+  for (uint8_t i = MAX_ENTRIES - 1; i > 0; i--) {
+    _entries[i] = _entries[i - 1];
+  }
+  _entries[0].hash = hash;
+  _entries[0].dir = dir;
+  _entries[0].index = index;
+}
+
+void SdCache::remove(uint8_t i) {
+  for (; i < MAX_ENTRIES - 1; i++) {
+    _entries[i] = _entries[i + 1];
+  }
+  _entries[MAX_ENTRIES - 1].hash = 0;
+}
@@ -0,0 +1,128 @@
+#ifndef SD_CACHE_H
+#define SD_CACHE_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+/**
+ * @brief Cache of resolved directory entries, so reopening a file skips walking its directory for the name
+ * A few directories are kept open and each path's hash maps to its directory and index in it. A cached
+ * file is opened by index and its name checked, a file that's been removed or renamed is looked up again
+ */
+class SdCache {
+  public:
+    /**
+     * @brief Directories kept open
+     */
+    static const uint8_t MAX_DIRS = 3;
+    /**
+     * @brief Paths cached
+     */
+    static const uint8_t MAX_ENTRIES = 12;
+    /**
+     * @brief Set the file system, call before anything else
+     * 
+     * @param sd 
+     */
+    static void begin(SdFat *sd);
+    /**
+     * @brief Open a file to read, from the cache if it's been opened before
+     * 
+     * @param file 
+     * @param path Absolute path
+     * @return true 
+     * @return false It doesn't exist
+     */
+    static bool open(FatFile &file, const char *path);
+    /**
+     * @brief Does a file exist, the file is cached for when it's opened
+     * 
+     * @param path 
+     * @return true 
+     * @return false 
+     */
+    static bool exists(const char *path);
+    /**
+     * @brief FNV-1a hash of a path, used as its key
+     * 
+     * @param path 
+     * @return uint32_t 
+     */
+    static uint32_t hash(const char *path);
+    /**
+     * @brief Opens from the cache
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getHits();
+    /**
+     * @brief Opens that had to walk the directory
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getMisses();
+  private:
+    /**
+     * @brief An open directory
+     */
+    struct Dir {
+      uint32_t hash; // Of the directory path, 0 if unused
+      FatFile file;
+    };
+    /**
+     * @brief A cached path
+     */
+    struct Entry {
+      uint32_t hash; // Of the path, 0 if unused
+      uint8_t dir; // Index in `_dirs`
+      uint16_t index; // Directory index of the file in `dir`
+    };
+    /**
+     * @brief Pointer to `SdFat` object
+     */
+    static SdFat *_sd;
+    /**
+     * @brief Open directories
+     */
+    static Dir _dirs[MAX_DIRS];
+    /**
+     * @brief Slot the next directory opened replaces, they're replaced in turn
+     */
+    static uint8_t _nextDir;
+    /**
+     * @brief Cached paths, most recently used first
+     */
+    static Entry _entries[MAX_ENTRIES];
+    /**
+     * @brief Opens from the cache
+     */
+    static uint16_t _hits;
+    /**
+     * @brief Opens that had to walk the directory
+     */
+    static uint16_t _misses;
+    /**
+     * @brief Find or open a directory
+     * 
+     * @param path The directory, not terminated
+     * @param length 
+     * @return uint8_t Index in `_dirs`, `MAX_DIRS` if it couldn't be opened
+     */
+    static uint8_t openDir(const char *path, uint8_t length);
+    /**
+     * @brief Cache a path, replacing the least recently used
+     * 
+     * @param hash 
+     * @param dir 
+     * @param index 
+     */
+    static void add(uint32_t hash, uint8_t dir, uint16_t index);
+    /**
+     * @brief Remove a cached path
+     * 
+     * @param i 
+     */
+    static void remove(uint8_t i);
+};
+
+#endif
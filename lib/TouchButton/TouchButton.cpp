@@ -1,6 +1,11 @@
 #include "TouchButton.h"
 #include <Adafruit_SPITFT.h>
 #include <Adafruit_ImageReader.h>
+#include <SdCache.h>
+
+IconAtlas::Entry TouchButton::_icons[TouchButton::MAX_ICONS] = { };
+uint8_t TouchButton::_nextIcon = 0;
+uint16_t TouchButton::_pinned = 0;
 
 TouchButton::TouchButton(Adafruit_SPITFT *tft, Adafruit_ImageReader *reader,
                          int16_t x, int16_t y, uint16_t w, uint16_t h,
@@ -85,13 +90,19 @@ void TouchButton::draw(bool pressed) {
   }
 
   if (_reader != nullptr && style->icon != nullptr) {
-    char icon[32];
-    sprintf_P(icon, PSTR("/icons/%s.bmp"), style->icon);
-    int32_t bmp_w, bmp_h;
-    if (_reader->bmpDimensions(icon, &bmp_w, &bmp_h) == IMAGE_SUCCESS
-      && _reader->drawBMP(icon, *_tft, text_x - (bmp_w / 2), text_y - (bmp_h / 2) - (text_h / 2) + 1, true) == IMAGE_SUCCESS)
-    { // Only change `text_x` if the icon was loaded successfully
-      text_x += (bmp_w / 2) + 2;
+    IconAtlas::Entry *icon = findIcon(_reader, style->icon, true);
+    int16_t icon_x = text_x - (icon->w / 2);
+    int16_t icon_y = text_y - (icon->h / 2) - (text_h / 2) + 1;
+    bool drawn = false;
+    if (icon->offset != 0) { // Pre-converted, written straight to the screen
+      drawn = IconAtlas::draw(_tft, *icon, icon_x, icon_y);
+    } else if (icon->w > 0) {
+      char path[32];
+      bmpPath(path, style->icon);
+      drawn = _reader->drawBMP(path, *_tft, icon_x, icon_y, true) == IMAGE_SUCCESS;
+    }
+    if (drawn) { // Only change `text_x` if the icon was loaded successfully
+      text_x += (icon->w / 2) + 2;
     }
   }
 
@@ -103,3 +114,56 @@ void TouchButton::draw(bool pressed) {
     _tft->print(_label);
   }
 }
+
+bool TouchButton::loadIcon(Adafruit_ImageReader *reader, const char *icon) {
+  return findIcon(reader, icon, false) != nullptr;
+}
+
+void TouchButton::unpinIcons() {
+  _pinned = 0;
+}
+
+IconAtlas::Entry *TouchButton::findIcon(Adafruit_ImageReader *reader, const char *icon, bool draw) {
+  uint32_t hash = IconAtlas::hash(icon);
+  uint8_t slot = 0;
+  while (slot < MAX_ICONS && _icons[slot].hash != hash) {
+    slot++;
+  }
+
+  if (slot == MAX_ICONS) {
+    slot = _nextIcon;
+    for (uint8_t tried = 0; !draw && (_pinned & (1U << slot)); tried++) {
+      if (tried == MAX_ICONS - 1) {
+        return nullptr; // Every icon is on screen, reading ahead would replace one
+      }
+      slot = (slot + 1) % MAX_ICONS;
+    }
+    _nextIcon = (slot + 1) % MAX_ICONS;
+    lookUpIcon(reader, icon, hash, _icons[slot]);
+  }
+  if (draw) {
+    _pinned |= 1U << slot;
+  }
+  return &_icons[slot];
+}
+
+void TouchButton::lookUpIcon(Adafruit_ImageReader *reader, const char *icon, uint32_t hash, IconAtlas::Entry &entry) {
+  if (IconAtlas::find(icon, entry)) {
+    return;
+  }
+
+  // Not in the atlas, fall back to the BMP
+  memset(&entry, 0, sizeof(entry));
+  entry.hash = hash;
+  char path[32];
+  bmpPath(path, icon);
+  int32_t bmp_w, bmp_h;
+  if (reader->bmpDimensions(path, &bmp_w, &bmp_h) == IMAGE_SUCCESS && bmp_w <= 255 && bmp_h <= 255) {
+    entry.w = bmp_w;
+    entry.h = bmp_h;
+  }
+}
+
+void TouchButton::bmpPath(char *path, const char *icon) {
+  sprintf_P(path, PSTR("/icons/%s.bmp"), icon);
+}
@@ -6,6 +6,7 @@
 #include <Adafruit_SPITFT.h>
 #include <Adafruit_ILI9341.h>
 #include <Adafruit_ImageReader.h>
+#include <IconAtlas.h>
 
 class TouchButton : public TouchRegion {
   public:
@@ -63,7 +64,37 @@ class TouchButton : public TouchRegion {
      * @param pressed Draw idle or pressed?
      */
     void draw(bool pressed = false);
+    /**
+     * @brief Look an icon up ahead of it being drawn, only replacing a cached icon that isn't on screen
+     * 
+     * @param reader 
+     * @param icon Name in `/icons`
+     * @return true 
+     * @return false Every cached icon is on screen, so it wasn't looked up
+     */
+    static bool loadIcon(Adafruit_ImageReader *reader, const char *icon);
+    /**
+     * @brief Mark every cached icon as off screen, call when the buttons drawn with them are destroyed
+     */
+    static void unpinIcons();
   private:
+    /**
+     * @brief Icons cached
+     */
+    static const uint8_t MAX_ICONS = 16; // A bit each in `_pinned`
+    /**
+     * @brief Icons looked up, so the atlas or BMP is only opened to draw them
+     * An offset of 0 is drawn from its BMP and a width of 0 couldn't be found, so it isn't looked up again
+     */
+    static IconAtlas::Entry _icons[MAX_ICONS];
+    /**
+     * @brief Slot the next icon replaces, they're replaced in turn
+     */
+    static uint8_t _nextIcon;
+    /**
+     * @brief Bit set for each cached icon drawn since `unpinIcons()`, icons looked up ahead don't replace them
+     */
+    static uint16_t _pinned;
     /**
      * @brief Pointer to TFT instance
      */
@@ -117,6 +148,31 @@ class TouchButton : public TouchRegion {
                   ILI9341_WHITE,
                   ILI9341_BLACK,
                 });
+    /**
+     * @brief Find an icon in the atlas, or its BMP if it isn't in the atlas, unless it's cached
+     * 
+     * @param reader 
+     * @param icon Name in `/icons`
+     * @param draw Is it being drawn, pinning it in the cache, or looked up ahead
+     * @return IconAtlas::Entry* `nullptr` if looked up ahead and every cached icon is pinned
+     */
+    static IconAtlas::Entry *findIcon(Adafruit_ImageReader *reader, const char *icon, bool draw);
+    /**
+     * @brief Read an icon's entry from the atlas, or its dimensions from the BMP if it isn't in the atlas
+     * 
+     * @param reader 
+     * @param icon Name in `/icons`
+     * @param hash Of `icon`
+     * @param entry 
+     */
+    static void lookUpIcon(Adafruit_ImageReader *reader, const char *icon, uint32_t hash, IconAtlas::Entry &entry);
+    /**
+     * @brief Path to an icon's BMP
+     * 
+     * @param path 
+     * @param icon 
+     */
+    static void bmpPath(char *path, const char *icon);
 };
 
 #endif
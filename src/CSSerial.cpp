@@ -0,0 +1,165 @@
+#include <CSSerial.h>
+#include <util/atomic.h>
+
+static_assert((CSSerial::RX_BUFFER_SIZE & (CSSerial::RX_BUFFER_SIZE - 1)) == 0, "CS_RX_BUFFER_SIZE must be a power of 2");
+static_assert((CSSerial::TX_BUFFER_SIZE & (CSSerial::TX_BUFFER_SIZE - 1)) == 0, "CS_TX_BUFFER_SIZE must be a power of 2");
+
+CSSerial csSerial;
+
+ISR(USART2_RX_vect) {
+  csSerial.rxInterrupt();
+}
+
+ISR(USART2_UDRE_vect) {
+  csSerial.txInterrupt();
+}
+
+void CSSerial::begin(uint32_t baud) {
+  // Double speed mode, same divisor as the core
+  uint16_t divisor = (F_CPU / 4 / baud - 1) / 2;
+  UCSR2A = _BV(U2X2);
+  UBRR2H = divisor >> 8;
+  UBRR2L = divisor;
+  UCSR2C = _BV(UCSZ21) | _BV(UCSZ20);
+  UCSR2B = _BV(RXEN2) | _BV(TXEN2) | _BV(RXCIE2);
+}
+
+int CSSerial::available() {
+  uint16_t head;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    head = _rxHead;
+  }
+  return (head - _rxTail) & (RX_BUFFER_SIZE - 1);
+}
+
+int CSSerial::peek() {
+  uint16_t head;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    head = _rxHead;
+  }
+  return head == _rxTail ? -1 : _rxBuffer[_rxTail];
+}
+
+int CSSerial::read() {
+  int c = peek();
+  if (c != -1) {
+    // Only this side writes the tail but the ISR reads it, so the 16 bit store mustn't be split
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      _rxTail = (_rxTail + 1) & (RX_BUFFER_SIZE - 1);
+    }
+  }
+  return c;
+}
+
+size_t CSSerial::write(uint8_t c) {
+  _written = true;
+
+  // Straight to the data register when idle, saves an interrupt per byte
+  if (_txHead == _txTail && bit_is_set(UCSR2A, UDRE2)) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      UDR2 = c;
+      UCSR2A = (UCSR2A & _BV(U2X2)) | _BV(TXC2); // Clear TXC2 for `flush()`
+    }
+    return 1;
+  }
+
+  uint8_t head = (_txHead + 1) & (TX_BUFFER_SIZE - 1);
+  while (head == _txTail) {
+    if (bit_is_clear(SREG, SREG_I) && bit_is_set(UCSR2A, UDRE2)) { // Interrupts are off, send a byte by hand
+      txInterrupt();
+    }
+  }
+
+  _txBuffer[_txHead] = c;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    _txHead = head;
+    UCSR2B |= _BV(UDRIE2);
+  }
+  return 1;
+}
+
+int CSSerial::availableForWrite() {
+  return (_txTail - _txHead - 1) & (TX_BUFFER_SIZE - 1);
+}
+
+void CSSerial::flush() {
+  if (!_written) { // TXC2 is only set once a byte has been sent, it would never be set
+    return;
+  }
+
+  while (bit_is_set(UCSR2B, UDRIE2) || bit_is_clear(UCSR2A, TXC2)) {
+    if (bit_is_clear(SREG, SREG_I) && bit_is_set(UCSR2B, UDRIE2) && bit_is_set(UCSR2A, UDRE2)) {
+      txInterrupt();
+    }
+  }
+}
+
+uint16_t CSSerial::getRxHighWater() {
+  uint16_t value;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    value = _rxHighWater;
+  }
+  return value;
+}
+
+uint16_t CSSerial::getRxDropped() {
+  uint16_t value;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    value = _rxDropped;
+  }
+  return value;
+}
+
+void CSSerial::resetRxStats() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    _rxHighWater = 0;
+    _rxDropped = 0;
+  }
+}
+
+void CSSerial::rxInterrupt() {
+  uint8_t status = UCSR2A;
+  uint8_t c = UDR2; // Always read to clear the interrupt
+  if (status & _BV(UPE2)) { // Parity error, same as the core
+    return;
+  }
+
+  if (status & _BV(DOR2)) { // The hardware lost a byte before this one
+    _rxDropped++;
+    _rxResync = true;
+  }
+
+  // Skip the rest of a frame that's lost bytes, `<` always starts a new one
+  if (_rxResync) {
+    if (c != '<') {
+      _rxDropped++;
+      return;
+    }
+    _rxResync = false;
+  }
+
+  uint16_t head = (_rxHead + 1) & (RX_BUFFER_SIZE - 1);
+  if (head == _rxTail) { // Full
+    _rxDropped++;
+    _rxResync = true;
+    return;
+  }
+
+  _rxBuffer[_rxHead] = c;
+  _rxHead = head;
+
+  uint16_t used = (head - _rxTail) & (RX_BUFFER_SIZE - 1);
+  if (used > _rxHighWater) {
+    _rxHighWater = used;
+  }
+}
+
+void CSSerial::txInterrupt() {
+  UDR2 = _txBuffer[_txTail];
+  _txTail = (_txTail + 1) & (TX_BUFFER_SIZE - 1);
+  UCSR2A = (UCSR2A & _BV(U2X2)) | _BV(TXC2);
+
+  if (_txHead == _txTail) { // Nothing left to send
+    UCSR2B &= ~_BV(UDRIE2);
+  }
+}
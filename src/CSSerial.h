@@ -0,0 +1,143 @@
+#ifndef CS_SERIAL_H
+#define CS_SERIAL_H
+
+#include <Arduino.h>
+
+#ifndef CS_RX_BUFFER_SIZE
+#define CS_RX_BUFFER_SIZE 512
+#endif
+#ifndef CS_TX_BUFFER_SIZE
+#define CS_TX_BUFFER_SIZE 64
+#endif
+
+/**
+ * @brief Interrupt driven USART2 for the CS link, replaces `Serial2`
+ * The RX ring is large enough to ride out SD reads and TFT fills, lost bytes are counted and the
+ * stream is resynced at the next `<` so a partial frame is never joined to a later one
+ * `Serial2` must not be used as the core's USART2 interrupts would clash with these
+ */
+class CSSerial : public Stream {
+  public:
+    /**
+     * @brief RX ring size, must be a power of 2
+     */
+    static const uint16_t RX_BUFFER_SIZE = CS_RX_BUFFER_SIZE;
+    /**
+     * @brief TX ring size, must be a power of 2
+     */
+    static const uint8_t TX_BUFFER_SIZE = CS_TX_BUFFER_SIZE;
+    /**
+     * @brief Start the USART, 8N1
+     *
+     * @param baud
+     */
+    void begin(uint32_t baud);
+    /**
+     * @brief Bytes waiting in the RX ring
+     *
+     * @return int
+     */
+    int available() override;
+    /**
+     * @brief Next byte in the RX ring without removing it
+     *
+     * @return int -1 if the ring is empty
+     */
+    int peek() override;
+    /**
+     * @brief Remove the next byte from the RX ring
+     *
+     * @return int -1 if the ring is empty
+     */
+    int read() override;
+    /**
+     * @brief Queue a byte to send, blocks while the TX ring is full
+     *
+     * @param c
+     * @return size_t
+     */
+    size_t write(uint8_t c) override;
+    using Print::write;
+    /**
+     * @brief Bytes that can be written without blocking
+     *
+     * @return int
+     */
+    int availableForWrite() override;
+    /**
+     * @brief Block until the TX ring has been sent, returns straight away if nothing has been written
+     */
+    void flush() override;
+    /**
+     * @brief Get the most bytes the RX ring has held
+     *
+     * @return uint16_t
+     */
+    uint16_t getRxHighWater();
+    /**
+     * @brief Get the number of RX bytes lost to a full ring, a hardware overrun or a resync
+     *
+     * @return uint16_t
+     */
+    uint16_t getRxDropped();
+    /**
+     * @brief Reset the high water mark and dropped count
+     */
+    void resetRxStats();
+    /**
+     * @brief Called by the RX complete interrupt
+     */
+    void rxInterrupt();
+    /**
+     * @brief Called by the data register empty interrupt
+     */
+    void txInterrupt();
+  private:
+    /**
+     * @brief RX ring storage
+     */
+    uint8_t _rxBuffer[RX_BUFFER_SIZE];
+    /**
+     * @brief Index the ISR writes the next byte to
+     */
+    volatile uint16_t _rxHead = 0;
+    /**
+     * @brief Index of the next byte to read
+     */
+    volatile uint16_t _rxTail = 0;
+    /**
+     * @brief Most bytes the RX ring has held
+     */
+    volatile uint16_t _rxHighWater = 0;
+    /**
+     * @brief RX bytes lost
+     */
+    volatile uint16_t _rxDropped = 0;
+    /**
+     * @brief Dropping bytes until the next `<` after a loss
+     */
+    volatile bool _rxResync = false;
+    /**
+     * @brief TX ring storage
+     */
+    uint8_t _txBuffer[TX_BUFFER_SIZE];
+    /**
+     * @brief Index the next byte is written to
+     */
+    volatile uint8_t _txHead = 0;
+    /**
+     * @brief Index the ISR sends the next byte from
+     */
+    volatile uint8_t _txTail = 0;
+    /**
+     * @brief Has anything been written, `flush()` returns straight away until it has
+     */
+    bool _written = false;
+};
+
+/**
+ * @brief CS link on USART2, pins 16 & 17
+ */
+extern CSSerial csSerial;
+
+#endif
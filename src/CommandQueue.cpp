@@ -0,0 +1,121 @@
+#include <CommandQueue.h>
+
+/**
+ * @brief Powers of 10 used by `putNumber()`
+ */
+const uint16_t POWERS_OF_10[] PROGMEM = { 10000, 1000, 100, 10 };
+
+CommandQueue::CommandQueue(uint8_t *buffer, uint8_t size)
+    : _buffer(buffer), _size(size) { }
+
+void CommandQueue::begin() {
+  _pending = HEADER;
+}
+
+bool CommandQueue::put(char c) {
+  // `_pending` is 0 once a command has overflowed so the rest of it is dropped
+  if (_pending == 0 || _used + _pending >= _size) {
+    _pending = 0;
+    return false;
+  }
+
+  _buffer[index(_tail, _pending++)] = c;
+  return true;
+}
+
+void CommandQueue::putNumber(int32_t value) {
+  if (value < 0) {
+    put('-');
+    value = -value;
+  }
+
+  uint16_t n = value;
+  bool leading = true; // Skip leading zeros
+  for (uint8_t i = 0; i < sizeof(POWERS_OF_10) / sizeof(POWERS_OF_10[0]); i++) {
+    uint16_t power = pgm_read_word(&POWERS_OF_10[i]);
+    char digit = '0';
+    while (n >= power) {
+      n -= power;
+      digit++;
+    }
+    if (digit != '0' || !leading) {
+      put(digit);
+      leading = false;
+    }
+  }
+  put('0' + n);
+}
+
+bool CommandQueue::commit(uint8_t tag) {
+  if (_pending == 0 || _used + _pending > _size) {
+    _pending = 0;
+    return false;
+  }
+
+  uint32_t now = micros();
+  _buffer[_tail] = _pending - HEADER;
+  _buffer[index(_tail, 1)] = tag;
+  for (uint8_t i = 0; i < 4; i++) {
+    _buffer[index(_tail, 2 + i)] = now >> (i * 8);
+  }
+
+  _tail = index(_tail, _pending);
+  _used += _pending;
+  _pending = 0;
+  return true;
+}
+
+bool CommandQueue::isEmpty() {
+  return _used == 0;
+}
+
+uint8_t CommandQueue::length() {
+  return _buffer[_head];
+}
+
+uint8_t CommandQueue::tag() {
+  return _buffer[index(_head, 1)];
+}
+
+uint32_t CommandQueue::queuedMicros() {
+  uint32_t queued = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    queued |= (uint32_t)_buffer[index(_head, 2 + i)] << (i * 8);
+  }
+  return queued;
+}
+
+char CommandQueue::at(uint8_t i) {
+  return _buffer[index(_head, HEADER + i)];
+}
+
+void CommandQueue::pop() {
+  uint8_t length = HEADER + _buffer[_head];
+  _head = index(_head, length);
+  _used -= length;
+}
+
+void CommandQueue::remove(char opcode) {
+  uint8_t read = _head;
+  uint8_t write = _head;
+  uint8_t left = _used;
+  _used = 0;
+  while (left > 0) { // Kept commands are moved up over the removed ones
+    uint8_t length = HEADER + _buffer[read];
+    left -= length;
+    if (_buffer[index(read, HEADER + 1)] != opcode) {
+      for (uint8_t i = 0; i < length; i++) {
+        _buffer[index(write, i)] = _buffer[index(read, i)];
+      }
+      write = index(write, length);
+      _used += length;
+    }
+    read = index(read, length);
+  }
+  _tail = write;
+}
+
+uint8_t CommandQueue::index(uint8_t from, uint8_t offset) {
+  uint16_t i = from + offset;
+  return i >= _size ? i - _size : i;
+}
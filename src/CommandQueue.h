@@ -0,0 +1,127 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Ring buffer of CS commands waiting to be written to the serial
+ * Each command is stored with its length, a tag and the `micros()` it was queued at
+ */
+class CommandQueue {
+  public:
+    /**
+     * @brief Bytes stored with each command, length, tag and 4 byte timestamp
+     */
+    static const uint8_t HEADER = 6;
+    /**
+     * @brief Construct a new `CommandQueue` object
+     * 
+     * @param buffer Storage for the queue
+     * @param size Size of `buffer`
+     */
+    CommandQueue(uint8_t *buffer, uint8_t size);
+    /**
+     * @brief Start a new command, any uncommitted command is discarded
+     */
+    void begin();
+    /**
+     * @brief Add a character to the command started with `begin()`
+     * 
+     * @param c 
+     * @return true 
+     * @return false The queue is full, the command will be discarded
+     */
+    bool put(char c);
+    /**
+     * @brief Add a number to the command started with `begin()`
+     * Formatted by repeated subtraction as AVR has no divide instruction, only 16 bit magnitudes are supported
+     * 
+     * @param value -65535 to 65535
+     */
+    void putNumber(int32_t value);
+    /**
+     * @brief Add the command started with `begin()` to the queue
+     * 
+     * @param tag Value returned by `tag()` when the command is at the front
+     * @return true 
+     * @return false The command didn't fit and was discarded
+     */
+    bool commit(uint8_t tag);
+    /**
+     * @brief Is the queue empty
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool isEmpty();
+    /**
+     * @brief Length of the command at the front of the queue
+     * 
+     * @return uint8_t 
+     */
+    uint8_t length();
+    /**
+     * @brief Tag of the command at the front of the queue
+     * 
+     * @return uint8_t 
+     */
+    uint8_t tag();
+    /**
+     * @brief `micros()` when the command at the front of the queue was committed
+     * 
+     * @return uint32_t 
+     */
+    uint32_t queuedMicros();
+    /**
+     * @brief Character `i` of the command at the front of the queue
+     * 
+     * @param i 
+     * @return char 
+     */
+    char at(uint8_t i);
+    /**
+     * @brief Remove the command at the front of the queue
+     */
+    void pop();
+    /**
+     * @brief Remove every command with an opcode, the rest keep their order and timestamps
+     * 
+     * @param opcode The character after `<`
+     */
+    void remove(char opcode);
+  private:
+    /**
+     * @brief Queue storage
+     */
+    uint8_t *_buffer;
+    /**
+     * @brief Size of `_buffer`
+     */
+    uint8_t _size;
+    /**
+     * @brief Index of the front command's header
+     */
+    uint8_t _head = 0;
+    /**
+     * @brief Index after the last committed command
+     */
+    uint8_t _tail = 0;
+    /**
+     * @brief Bytes used by committed commands
+     */
+    uint8_t _used = 0;
+    /**
+     * @brief Length of the command being added, including the header
+     */
+    uint8_t _pending = 0;
+    /**
+     * @brief Index `offset` bytes on from `from`, wrapping at the end of the buffer
+     * 
+     * @param from 
+     * @param offset 
+     * @return uint8_t 
+     */
+    uint8_t index(uint8_t from, uint8_t offset);
+};
+
+#endif
@@ -1,160 +1,771 @@
 #include <DCCEx.h>
-#include <Regexp.h>
 
-DCCEx::DCCEx(HardwareSerial *serial, uint16_t timeout)
-    : _serial(serial) {
+const DCCEx::RoundTripLimits DCCEx::ROUND_TRIP_LIMITS[RoundTripClass::COUNT] PROGMEM = {
+  { 20, 250, 2 }, // THROTTLE
+  { 250, 1000, 0 }, // HEARTBEAT, missed heartbeats are counted rather than retried
+  { 500, 8000, 1 }, // ADDRESS
+  { 200, 5000, 1 } // CV
+};
+
+DCCEx::DCCEx(CSSerial *serial, uint16_t timeout)
+    : _serial(serial), _tx{
+        CommandQueue(_txBuffer, 32),
+        CommandQueue(_txBuffer + 32, 96),
+        CommandQueue(_txBuffer + 128, 64),
+        CommandQueue(_txBuffer + 192, 48)
+      }, _timeout(timeout) {
+  memset(_histograms, 0, sizeof(_histograms));
   _serial->begin(115200);
-  _serial->setTimeout(timeout);
 }
 
-uint16_t DCCEx::readCSResponse(char *buffer, uint16_t length) {
-  return _serial->readBytesUntil('\n', buffer, length);
+void DCCEx::loop() {
+  flush();
+
+  // Parse whatever has arrived, a response is only processed once its frame is complete
+  while (_serial->available()) {
+    if (_parser.parse(_serial->read())) {
+      // Anything from the CS shows the link is up
+      _linkMillis = millis();
+      _heartbeatMisses = 0;
+      setLinkState(LinkState::CONNECTED);
+
+      trace(_parser.frame().opcode, true);
+      // Both are tried as a response can also be a broadcast, e.g. `<p1>` after `<1>`
+      bool matched = processResponse(_parser.frame());
+      if (!processBroadcast(_parser.frame()) && !matched) {
+        _unmatched++;
+      }
+    }
+  }
+
+  // Send throttle changes that have waited out the interval
+  for (uint8_t i = 0; i < MAX_THROTTLES; i++) {
+    if (_throttles[i].dirty && millis() - _throttles[i].sentMillis >= _throttleInterval) {
+      sendThrottle(_throttles[i]);
+    }
+  }
+
+  // Retry or time out requests the CS hasn't responded to
+  for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+    if (_requests[i].state != RequestState::PENDING) {
+      continue;
+    }
+    if (_requests[i].sent && millis() - _requests[i].sentMillis > getTimeout(_requests[i])) {
+      retry(i);
+    } else if (!_requests[i].sent &&
+               millis() - _requests[i].sentMillis > pgm_read_word(&ROUND_TRIP_LIMITS[getRoundTripClass(_requests[i].type)].ceiling)) {
+      _timeouts++;
+      complete(_requests[i], false, -1); // Never got to the serial, so `wait()` can't spin forever
+    }
+  }
+
+  heartbeat();
+  negotiate();
+}
+
+RoundTripClass DCCEx::getRoundTripClass(uint8_t type) {
+  switch (type) {
+    case RequestType::THROTTLE: return RoundTripClass::THROTTLE;
+    case RequestType::HEARTBEAT:
+    case RequestType::STATUS: return RoundTripClass::HEARTBEAT;
+    case RequestType::WRITE_ADDRESS:
+    case RequestType::READ_ADDRESS: return RoundTripClass::ADDRESS;
+    default: return RoundTripClass::CV;
+  }
+}
+
+uint16_t DCCEx::getTimeout(RoundTripClass roundTripClass) {
+  RoundTrip &roundTrip = _roundTrips[roundTripClass];
+  // `deviation` is already scaled by 4
+  uint16_t timeout = roundTrip.smoothed == 0 ? _timeout : (roundTrip.smoothed >> 3) + roundTrip.deviation;
+  uint16_t floor = pgm_read_word(&ROUND_TRIP_LIMITS[roundTripClass].floor);
+  uint16_t ceiling = pgm_read_word(&ROUND_TRIP_LIMITS[roundTripClass].ceiling);
+  return timeout < floor ? floor : timeout > ceiling ? ceiling : timeout;
+}
+
+uint16_t DCCEx::getTimeout(Request &request) {
+  RoundTripClass roundTripClass = getRoundTripClass(request.type);
+  uint32_t timeout = (uint32_t)getTimeout(roundTripClass) << request.retries;
+  uint16_t ceiling = pgm_read_word(&ROUND_TRIP_LIMITS[roundTripClass].ceiling);
+  return timeout > ceiling ? ceiling : timeout;
+}
+
+void DCCEx::addRoundTrip(RoundTripClass roundTripClass, uint16_t rtt) {
+  RoundTrip &roundTrip = _roundTrips[roundTripClass];
+  uint16_t ceiling = pgm_read_word(&ROUND_TRIP_LIMITS[roundTripClass].ceiling);
+  if (rtt > ceiling) { // Keeps the scaled values within 16 bits
+    rtt = ceiling;
+  } else if (rtt == 0) { // 0 is unmeasured
+    rtt = 1;
+  }
+
+  if (roundTrip.smoothed == 0) { // First sample, deviation starts at half the round trip
+    roundTrip.smoothed = rtt << 3;
+    roundTrip.deviation = rtt << 1;
+    return;
+  }
+
+  // Jacobson's estimator, smoothed += error / 8 and deviation += (|error| - deviation) / 4 in scaled units
+  int16_t error = rtt - (roundTrip.smoothed >> 3);
+  roundTrip.smoothed += error;
+  if (error < 0) {
+    error = -error;
+  }
+  roundTrip.deviation += error - (roundTrip.deviation >> 2);
+}
+
+uint16_t DCCEx::getRoundTrip(RoundTripClass roundTripClass) {
+  return _roundTrips[roundTripClass].smoothed >> 3;
+}
+
+uint16_t DCCEx::getRetries() {
+  return _retries;
+}
+
+void DCCEx::retry(uint8_t slot) {
+  Request &request = _requests[slot];
+  _timeouts++;
+  if (request.retries >= pgm_read_byte(&ROUND_TRIP_LIMITS[getRoundTripClass(request.type)].retries) ||
+      (request.type == RequestType::THROTTLE && isThrottlePending(request.args[2], slot))) {
+    complete(request, false, -1); // Out of retries, or a newer throttle change makes this one stale
+    return;
+  }
+
+  // A new sequence # keeps responses matching in send order
+  request.retries++;
+  request.sent = false;
+  request.sentMillis = millis(); // Queued time until it's sent
+  request.seq = _seq++;
+  _retries++;
+  if (!send((request.generation << 3) | slot)) {
+    complete(request, false, -1);
+  }
+}
+
+void DCCEx::heartbeat() {
+  if (_heartbeat != -1 || millis() - _linkMillis < HEARTBEAT_INTERVAL) {
+    return;
+  }
+
+  // `<#>` responds with `<# maxLocos>`, it's cheap for the CS and has no side effects
+  _heartbeat = newRequest(RequestType::HEARTBEAT, nullptr);
+  if (_heartbeat != -1 && !send(_heartbeat)) {
+    _heartbeat = -1;
+  }
+}
+
+void DCCEx::negotiate() {
+  if (!_negotiate || _status != -1) {
+    return;
+  }
+
+  // The response is several frames, `<iDCC-EX V-4.0.0 / ...>` is the one matched, power states are broadcasts
+  _status = newRequest(RequestType::STATUS, nullptr);
+  if (_status != -1 && !send(_status)) {
+    _status = -1;
+  }
+  _negotiate = _status == -1;
+}
+
+uint8_t DCCEx::getVersion() {
+  return _version;
+}
+
+uint8_t DCCEx::decodeSpeed(uint8_t speedByte) {
+  uint8_t speed = speedByte & 0x7F;
+  return speed > 1 ? speed - 1 : 0;
+}
+
+void DCCEx::setLinkState(LinkState state) {
+  if (state == _linkState) {
+    return;
+  }
+
+  if (_linkState == LinkState::LOST && _status == -1) { // The CS may have been restarted or changed
+    _negotiate = true;
+  }
+
+  LinkState previous = (LinkState)_linkState;
+  _linkState = state;
+  if (_linkListener != nullptr) {
+    _linkListener(state, previous);
+  }
+}
+
+RequestState DCCEx::poll(int8_t handle, int16_t *value) {
+  Request *request = getRequest(handle);
+  if (request == nullptr) {
+    return RequestState::EXPIRED;
+  }
+
+  if (value != nullptr) {
+    *value = request->value;
+  }
+  return (RequestState)request->state;
+}
+
+int8_t DCCEx::newRequest(RequestType type, Callback callback, uint16_t arg0, uint16_t arg1, uint16_t arg2) {
+  int8_t slot = -1;
+  for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+    if (_requests[i].state == RequestState::FREE) { // Unused slots first
+      slot = i;
+      break;
+    } else if (_requests[i].state != RequestState::PENDING &&
+               (slot == -1 || (uint8_t)(_seq - _requests[i].seq) > (uint8_t)(_seq - _requests[slot].seq))) {
+      slot = i; // Oldest completed slot
+    }
+  }
+
+  if (slot == -1) {
+    return -1;
+  }
+
+  Request &request = _requests[slot];
+  request.type = type;
+  request.state = RequestState::PENDING;
+  request.sent = false;
+  request.generation = (request.generation + 1) & 0x0F;
+  request.seq = _seq++;
+  request.retries = 0;
+  request.args[0] = arg0;
+  request.args[1] = arg1;
+  request.args[2] = arg2;
+  request.value = -1;
+  request.sentMillis = millis();
+  request.callback = callback;
+
+  // Low 3 bits are the slot, the next 4 are the generation
+  return (request.generation << 3) | slot;
+}
+
+bool DCCEx::send(int8_t handle) {
+  Request &request = _requests[handle & 0x07];
+  uint16_t *args = request.args;
+  switch (request.type) {
+    case RequestType::THROTTLE: {
+      if (isV4()) {
+        return command<'t'>(Lane::THROTTLE, handle, args[2], (int8_t)args[0], args[1]);
+      }
+      return command<'t'>(Lane::THROTTLE, handle, 1, args[2], (int8_t)args[0], args[1]);
+    }
+    case RequestType::WRITE_ADDRESS: return command<'W'>(Lane::PROGRAM, handle, args[0]);
+    case RequestType::READ_ADDRESS: return command<'R'>(Lane::PROGRAM, handle);
+    case RequestType::WRITE_CV_BYTE: return command<'W'>(Lane::PROGRAM, handle, args[0], args[1], 12345, 32767);
+    case RequestType::READ_CV_BYTE: return command<'R'>(Lane::PROGRAM, handle, args[0], 12345, 32767);
+    case RequestType::WRITE_CV_BIT: return command<'B'>(Lane::PROGRAM, handle, args[0], args[1], args[2], 12345, 32767);
+    case RequestType::HEARTBEAT: return command<'#'>(Lane::FUNCTION, handle);
+    case RequestType::STATUS: return command<'s'>(Lane::FUNCTION, handle);
+  }
+  return false;
+}
+
+DCCEx::Request *DCCEx::getRequest(int8_t handle) {
+  if (handle < 0) {
+    return nullptr;
+  }
+
+  Request &request = _requests[handle & 0x07];
+  if (request.state == RequestState::FREE || request.generation != (handle >> 3)) {
+    return nullptr;
+  }
+  return &request;
+}
+
+void DCCEx::complete(Request &request, bool success, int16_t value) {
+  request.state = success ? RequestState::SUCCESS : RequestState::FAILED;
+  request.value = value;
+  if (request.type == RequestType::HEARTBEAT) {
+    _heartbeat = -1;
+    _linkMillis = millis();
+    if (!success && _heartbeatMisses < HEARTBEAT_MISSES) {
+      _heartbeatMisses++;
+      setLinkState(_heartbeatMisses == HEARTBEAT_MISSES ? LinkState::LOST : LinkState::DEGRADED);
+    }
+  } else if (request.type == RequestType::STATUS) {
+    _status = -1;
+    if (success) {
+      _version = value;
+    }
+  }
+  if (request.callback != nullptr) {
+    request.callback(success, value);
+  }
+}
+
+bool DCCEx::processResponse(const DCCExFrame &frame) {
+  Request *oldest = nullptr;
+  bool success = false;
+  int16_t value = -1;
+
+  for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+    Request &request = _requests[i];
+    if (request.state != RequestState::PENDING ||
+        (oldest != nullptr && (uint8_t)(_seq - request.seq) < (uint8_t)(_seq - oldest->seq))) {
+      continue;
+    }
+
+    // Each type only matches its own response, a failed match leaves the request pending
+    switch (request.type) {
+      case RequestType::THROTTLE: {
+        if (isV4()) { // <l cab reg speedByte functMap>, matched by cab so pipelined locos can't be confused
+          if (frame.opcode == 'l' && frame.isNumber(3) && frame.fields[0] == request.args[2]) {
+            oldest = &request;
+            int8_t speed = request.args[0];
+            success = decodeSpeed(frame.fields[2]) == (speed < 0 ? 0 : speed) &&
+                      ((uint8_t)frame.fields[2] >> 7) == request.args[1];
+          }
+        } else if (frame.opcode == 'T' && frame.isNumber(2) && frame.fields[0] == 1) { // <T 1 speed dir>
+          oldest = &request;
+          success = frame.fields[1] == (int8_t)request.args[0] && frame.fields[2] == request.args[1];
+        }
+      } break;
+      case RequestType::WRITE_ADDRESS: { // <w address>
+        if (frame.opcode == 'w' && frame.count == 1 && frame.isNumber(0)) {
+          oldest = &request;
+          success = frame.fields[0] == request.args[0];
+        }
+      } break;
+      case RequestType::READ_ADDRESS: { // <r address>
+        if (frame.opcode == 'r' && frame.count == 1 && frame.isNumber(0)) {
+          oldest = &request;
+          value = frame.fields[0];
+          success = value != -1;
+        }
+      } break;
+      case RequestType::WRITE_CV_BYTE:
+      case RequestType::READ_CV_BYTE: { // <r12345|32767|cv value>
+        if (frame.opcode == 'r' && frame.count == 4 && frame.isNumber(3) &&
+            frame.fields[0] == 12345 && frame.fields[1] == 32767 && frame.fields[2] == request.args[0]) {
+          oldest = &request;
+          value = frame.fields[3];
+          success = value != -1 && (request.type == RequestType::READ_CV_BYTE || value == request.args[1]);
+        }
+      } break;
+      case RequestType::HEARTBEAT: { // <# maxLocos>
+        if (frame.opcode == '#') {
+          oldest = &request;
+          success = true;
+        }
+      } break;
+      case RequestType::STATUS: { // <iDCC-EX V-4.0.0 / MEGA / STANDARD_MOTOR_SHIELD G-3bddf4d>
+        if (frame.opcode == 'i') {
+          oldest = &request;
+          for (uint8_t f = 0; f < frame.count; f++) {
+            if (frame.text(f) == 'V') {
+              value = frame.textNumber(f);
+              break;
+            }
+          }
+          success = value > 0;
+        }
+      } break;
+      case RequestType::WRITE_CV_BIT: { // <r12345|32767|cv bit value>
+        if (frame.opcode == 'r' && frame.count == 5 && frame.isNumber(4) &&
+            frame.fields[0] == 12345 && frame.fields[1] == 32767 &&
+            frame.fields[2] == request.args[0] && frame.fields[3] == request.args[1]) {
+          oldest = &request;
+          value = frame.fields[4];
+          success = value == request.args[2];
+        }
+      } break;
+    }
+  }
+
+  if (oldest == nullptr) {
+    return false;
+  }
+
+  // Only first sends are measured, a retried request's response could be to either send
+  if (oldest->sent && oldest->retries == 0) {
+    uint16_t rtt = millis() - oldest->sentMillis;
+    addRoundTrip(getRoundTripClass(oldest->type), rtt);
+
+    uint8_t bucket = 0;
+    while (rtt > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+      rtt >>= 1;
+      bucket++;
+    }
+    if (_histograms[oldest->type][bucket] < UINT16_MAX) {
+      _histograms[oldest->type][bucket]++;
+    }
+  }
+  complete(*oldest, success, success ? value : -1);
+  return true;
+}
+
+bool DCCEx::processBroadcast(const DCCExFrame &frame) {
+  if (frame.opcode == 'l' && frame.isNumber(3)) { // <l cab reg speedByte functMap>
+    uint16_t address = frame.fields[0];
+    if (_locoListener == nullptr || isThrottlePending(address)) {
+      return true;
+    }
+
+    uint8_t speedByte = frame.fields[2];
+    _locoListener(address, decodeSpeed(speedByte), speedByte >> 7, frame.fields[3]);
+  } else if (frame.opcode == 'p' && frame.isNumber(0)) { // <p0> <p1> <p1 MAIN> <p0 PROG> <p1 JOIN>
+    // `<p1 JOIN>` powers both tracks so it's treated as all
+    Track track = Track::ALL;
+    if (frame.text(1) == 'M') {
+      track = Track::MAIN;
+    } else if (frame.text(1) == 'P') {
+      track = Track::PROG;
+    }
+    bool on = frame.fields[0];
+    uint8_t mask = track == Track::ALL ? (1 << Track::MAIN) | (1 << Track::PROG) : 1 << track;
+    _power = on ? _power | mask : _power & ~mask;
+
+    if (_powerListener != nullptr) {
+      _powerListener(track, on);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool DCCEx::isThrottlePending(uint16_t address, int8_t exclude) {
+  for (uint8_t i = 0; i < MAX_THROTTLES; i++) {
+    if (_throttles[i].dirty && _throttles[i].address == address) {
+      return true;
+    }
+  }
+  for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+    if (i != exclude && _requests[i].state == RequestState::PENDING && _requests[i].type == RequestType::THROTTLE &&
+        _requests[i].args[2] == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DCCEx::commit(Lane lane, int8_t handle) {
+  if (!_tx[lane].commit(handle == -1 ? 0xFF : handle)) {
+    _txDropped++;
+    if (handle != -1) { // Request never sent so free it
+      _requests[handle & 0x07].state = RequestState::FREE;
+    }
+    return false;
+  }
+
+  flush();
+  return true;
+}
+
+bool DCCEx::enqueue(Lane lane, const __FlashStringHelper *command) {
+  CommandQueue &queue = _tx[lane];
+  const char *c = (const char *)command;
+  queue.begin();
+  while (pgm_read_byte(c)) {
+    queue.put(pgm_read_byte(c++));
+  }
+  return commit(lane, -1);
+}
+
+void DCCEx::flush() {
+  for (uint8_t lane = 0; lane < Lane::COUNT; lane++) {
+    CommandQueue &queue = _tx[lane];
+    while (!queue.isEmpty()) {
+      Request *request = queue.tag() != 0xFF ? getRequest(queue.tag()) : nullptr;
+      if (queue.tag() != 0xFF && (request == nullptr || request->state != RequestState::PENDING)) {
+        queue.pop(); // Failed before it was sent, e.g. waited too long to be sent
+        continue;
+      }
+
+      uint8_t length = queue.length() + 1; // Command and newline
+      int free = _serial->availableForWrite();
+      int backlog = CSSerial::TX_BUFFER_SIZE - 1 - free;
+      // Lower lanes only fill the TX buffer up to the backlog so an emergency stop is never stuck behind them,
+      // a command longer than the backlog goes once the buffer is empty
+      if (free < length || (lane != Lane::EMERGENCY && backlog > 0 && backlog + length > TX_BACKLOG)) {
+        return; // Never write a lower lane while a higher one is waiting
+      }
+
+      for (uint8_t i = 0; i < length - 1; i++) {
+        _serial->write(queue.at(i));
+      }
+      _serial->write('\n');
+
+      trace(queue.at(1), false);
+      uint32_t latency = micros() - queue.queuedMicros();
+      if (latency > _txLatency[lane]) {
+        _txLatency[lane] = latency;
+      }
+      if (request != nullptr) {
+        request->sent = true;
+        request->sentMillis = millis();
+      }
+      queue.pop();
+    }
+  }
+}
+
+uint32_t DCCEx::getTxLatency(Lane lane) {
+  return _txLatency[lane];
+}
+
+void DCCEx::resetTxLatency() {
+  memset(_txLatency, 0, sizeof(_txLatency));
+}
+
+uint16_t DCCEx::getTxDropped() {
+  return _txDropped;
+}
+
+uint16_t DCCEx::getTimeouts() {
+  return _timeouts;
+}
+
+uint16_t DCCEx::getUnmatched() {
+  return _unmatched;
+}
+
+uint16_t DCCEx::getHistogram(RequestType type, uint8_t bucket) {
+  return _histograms[type][bucket];
+}
+
+void DCCEx::trace(char opcode, bool rx) {
+  TraceEntry &entry = _trace[_traceHead];
+  entry.micros = micros();
+  entry.opcode = opcode;
+  entry.rx = rx;
+  _traceHead = (_traceHead + 1) % TRACE_SIZE;
+  if (_traceCount < TRACE_SIZE) {
+    _traceCount++;
+  }
+}
+
+void DCCEx::dumpTrace(Print &out) {
+  // Times are relative to the previous frame so bursts are easy to spot
+  uint8_t i = (_traceHead + TRACE_SIZE - _traceCount) % TRACE_SIZE;
+  uint32_t previous = _trace[i].micros;
+  for (uint8_t n = 0; n < _traceCount; n++, i = (i + 1) % TRACE_SIZE) {
+    out.print(_trace[i].rx ? F("RX ") : F("TX "));
+    out.print(_trace[i].opcode);
+    out.print(F(" +"));
+    out.println(_trace[i].micros - previous);
+    previous = _trace[i].micros;
+  }
+
+  // One line per request type, ms round trip buckets <1 1 2-3 4-7 ...
+  for (uint8_t type = 0; type < RequestType::COUNT; type++) {
+    out.print(F("RTT "));
+    out.print(type);
+    out.print(':');
+    for (uint8_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+      out.print(' ');
+      out.print(_histograms[type][bucket]);
+    }
+    out.println();
+  }
+
+  out.print(F("Timeouts "));
+  out.print(_timeouts);
+  out.print(F(" retries "));
+  out.print(_retries);
+  out.print(F(" unmatched "));
+  out.print(_unmatched);
+  out.print(F(" TX dropped "));
+  out.println(_txDropped);
+}
+
+void DCCEx::resetTrace() {
+  _traceCount = 0;
+  _timeouts = 0;
+  _retries = 0;
+  _unmatched = 0;
+  memset(_histograms, 0, sizeof(_histograms));
+}
+
+bool DCCEx::wait(int8_t handle, int16_t *value) {
+  while (poll(handle) == RequestState::PENDING) {
+    loop();
+  }
+  return poll(handle, value) == RequestState::SUCCESS;
+}
+
+void DCCEx::setLocoListener(LocoListener listener) {
+  _locoListener = listener;
+}
+
+void DCCEx::setPowerListener(PowerListener listener) {
+  _powerListener = listener;
 }
 
-void DCCEx::clearCSResponse() {
-  _serial->read();
+bool DCCEx::isPowerOn(Track track) {
+  if (track == Track::ALL) {
+    return _power == ((1 << Track::MAIN) | (1 << Track::PROG));
+  }
+  return _power & (1 << track);
+}
+
+void DCCEx::setLinkListener(LinkListener listener) {
+  _linkListener = listener;
+}
+
+LinkState DCCEx::getLinkState() {
+  return (LinkState)_linkState;
 }
 
 void DCCEx::powerOff(Track track) {
   if (track == Track::ALL) {
-    _serial->println(F("<0>"));
+    enqueue(Lane::EMERGENCY, F("<0>"));
   } else if (track == Track::MAIN) {
-    _serial->println(F("<0 MAIN>"));
+    enqueue(Lane::EMERGENCY, F("<0 MAIN>"));
   } else if (track == Track::PROG) {
-    _serial->println(F("<0 PROG>"));
+    enqueue(Lane::EMERGENCY, F("<0 PROG>"));
   }
 }
 
 void DCCEx::powerOn(Track track) {
   if (track == Track::ALL) {
-    _serial->println(F("<1>"));
+    enqueue(Lane::THROTTLE, F("<1>"));
   } else if (track == Track::MAIN) {
-    _serial->println(F("<1 MAIN>"));
+    enqueue(Lane::THROTTLE, F("<1 MAIN>"));
   } else if (track == Track::PROG) {
-    _serial->println(F("<1 PROG>"));
+    enqueue(Lane::THROTTLE, F("<1 PROG>"));
   }
 }
 
 void DCCEx::powerJoin() {
-  _serial->println(F("<1 JOIN>"));
+  enqueue(Lane::THROTTLE, F("<1 JOIN>"));
 }
 
 void DCCEx::emergencyStopAll() {
-  _serial->println(F("<!>"));
+  enqueue(Lane::EMERGENCY, F("<!>"));
+
+  // Drop queued throttle changes so they can't restart a loco after the stop, releases and power on stay queued
+  _tx[Lane::THROTTLE].remove('t');
+  for (uint8_t i = 0; i < MAX_THROTTLES; i++) {
+    _throttles[i].dirty = false;
+  }
+  // Sent changes are failed too so a retry can't resend them
+  for (uint8_t i = 0; i < MAX_REQUESTS; i++) {
+    if (_requests[i].state == RequestState::PENDING && _requests[i].type == RequestType::THROTTLE) {
+      complete(_requests[i], false, -1);
+    }
+  }
+}
+
+int8_t DCCEx::setThrottleAsync(uint16_t address, int8_t speed, uint8_t direction, Callback callback) {
+  int8_t handle = newRequest(RequestType::THROTTLE, callback, speed, direction, address);
+  return handle != -1 && send(handle) ? handle : -1;
 }
 
 bool DCCEx::setThrottle(uint16_t address, int8_t speed, uint8_t direction) {
-  char buf[18];
-  sprintf_P(buf, PSTR("<t 1 %d %d %d>"), address, speed, direction);
-  _serial->println(buf);
+  return wait(setThrottleAsync(address, speed, direction));
+}
 
-  memset(buf, 0, sizeof(buf));
-  MatchState ms(buf, sizeof(buf));
-  char pattern[18];
-  strncpy_P(pattern, PSTR("<T 1 (%d+) (%d+)>"), sizeof(pattern));
+void DCCEx::queueThrottle(uint16_t address, int8_t speed, uint8_t direction) {
+  Throttle *throttle = nullptr;
+  for (uint8_t i = 0; i < MAX_THROTTLES; i++) {
+    if (_throttles[i].address == address) {
+      throttle = &_throttles[i];
+      break;
+    } else if (!_throttles[i].dirty &&
+               (throttle == nullptr || (int32_t)(_throttles[i].sentMillis - throttle->sentMillis) < 0)) {
+      throttle = &_throttles[i]; // Least recently sent idle slot
+    }
+  }
 
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED &&
-      (int8_t)strtol(ms.capture[0].init, (char **)NULL, 10) == speed &&
-      (uint8_t)strtoul(ms.capture[1].init, (char **)NULL, 10) == direction) {
-    return true;
+  if (throttle == nullptr) { // Every slot has a change waiting, send the oldest to make room
+    throttle = &_throttles[0];
+    for (uint8_t i = 1; i < MAX_THROTTLES; i++) {
+      if ((int32_t)(_throttles[i].sentMillis - throttle->sentMillis) < 0) {
+        throttle = &_throttles[i];
+      }
+    }
+    if (!sendThrottle(*throttle)) {
+      return;
+    }
   }
-  return false;
+
+  if (throttle->address != address) {
+    throttle->address = address;
+    throttle->sentDirection = direction;
+    throttle->sentMillis = millis() - _throttleInterval;
+  } else if (throttle->dirty) {
+    _throttlesSaved++;
+  }
+
+  throttle->speed = speed;
+  throttle->direction = direction;
+  throttle->dirty = true;
+
+  if (speed == 0 || direction != throttle->sentDirection || millis() - throttle->sentMillis >= _throttleInterval) {
+    sendThrottle(*throttle);
+  }
+}
+
+bool DCCEx::sendThrottle(Throttle &throttle) {
+  if (setThrottleAsync(throttle.address, throttle.speed, throttle.direction) == -1) {
+    return false;
+  }
+
+  throttle.sentDirection = throttle.direction;
+  throttle.sentMillis = millis();
+  throttle.dirty = false;
+  return true;
 }
 
-void DCCEx::setFn(uint16_t address, uint16_t fn, bool state) {
-  char buf[16];
-  sprintf_P(buf, PSTR("<F %d %d %d>"), address, fn, state);
-  _serial->println(buf);
+void DCCEx::setThrottleInterval(uint16_t interval) {
+  _throttleInterval = interval;
+}
+
+uint32_t DCCEx::getThrottlesSaved() {
+  return _throttlesSaved;
+}
+
+bool DCCEx::setFn(uint16_t address, uint16_t fn, bool state) {
+  return command<'F'>(Lane::FUNCTION, -1, address, fn, state);
 }
 
 void DCCEx::release(uint16_t address) {
-  char buf[10];
-  sprintf_P(buf, PSTR("<- %d>"), address);
-  _serial->println(buf);
+  command<'-'>(Lane::THROTTLE, -1, address);
 }
 
-bool DCCEx::writeAddress(uint16_t address) {
-  char buf[10];
-  sprintf_P(buf, PSTR("<W %d>"), address);
-  _serial->println(buf);
+int8_t DCCEx::writeAddressAsync(uint16_t address, Callback callback) {
+  int8_t handle = newRequest(RequestType::WRITE_ADDRESS, callback, address);
+  return handle != -1 && send(handle) ? handle : -1;
+}
 
-  memset(buf, 0, sizeof(buf));
-  MatchState ms(buf, sizeof(buf));
-  char pattern[10];
-  strncpy_P(pattern, PSTR("<w (%d+)>"), sizeof(pattern));
+bool DCCEx::writeAddress(uint16_t address) {
+  return wait(writeAddressAsync(address));
+}
 
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED &&
-      (uint16_t)strtoul(ms.capture[0].init, (char **)NULL, 10) == address) {
-    return true;
-  }
-  return false;
+int8_t DCCEx::readAddressAsync(Callback callback) {
+  int8_t handle = newRequest(RequestType::READ_ADDRESS, callback);
+  return handle != -1 && send(handle) ? handle : -1;
 }
 
 int16_t DCCEx::readAddress() {
-  char buf[10] = { 0 };
-  _serial->println(F("<R>"));
-
-  MatchState ms(buf, sizeof(buf));
-  char pattern[10];
-  strncpy_P(pattern, PSTR("<r (%d+)>"), sizeof(pattern));
+  int16_t value = -1;
+  return wait(readAddressAsync(), &value) ? value : -1;
+}
 
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED) {
-    return (int16_t)strtol(ms.capture[0].init, (char **)NULL, 10);
-  }
-  
-  return -1;
+int8_t DCCEx::writeCVByteAsync(uint16_t cv, uint8_t value, Callback callback) {
+  int8_t handle = newRequest(RequestType::WRITE_CV_BYTE, callback, cv, value);
+  return handle != -1 && send(handle) ? handle : -1;
 }
 
 bool DCCEx::writeCVByte(uint16_t cv, uint8_t value) {
-  char buf[24];
-  sprintf_P(buf, PSTR("<W %d %d 12345 32767>"), cv, value);
-  _serial->println(buf);
-
-  memset(buf, 0, sizeof(buf));
-  MatchState ms(buf, sizeof(buf));
-  char pattern[27];
-  strncpy_P(pattern, PSTR("<r12345|32767|(%d+) (%d+)>"), sizeof(pattern));
+  return wait(writeCVByteAsync(cv, value));
+}
 
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED &&
-      (uint16_t)strtoul(ms.capture[0].init, (char **)NULL, 10) == cv &&
-      (uint8_t)strtoul(ms.capture[1].init, (char **)NULL, 10) == value) {
-    return true;
-  }
-  return false;
+int8_t DCCEx::readCVByteAsync(uint16_t cv, Callback callback) {
+  int8_t handle = newRequest(RequestType::READ_CV_BYTE, callback, cv);
+  return handle != -1 && send(handle) ? handle : -1;
 }
 
 int16_t DCCEx::readCVByte(uint16_t cv) {
-  char buf[24];
-  sprintf_P(buf, PSTR("<R %d 12345 32767>"), cv);
-  _serial->println(buf);
-
-  memset(buf, 0, sizeof(buf));
-  MatchState ms(buf, sizeof(buf));
-  char pattern[27];
-  strncpy_P(pattern, PSTR("<r12345|32767|(%d+) (%d+)>"), sizeof(pattern));
+  int16_t value = -1;
+  return wait(readCVByteAsync(cv), &value) ? value : -1;
+}
 
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED &&
-      (uint16_t)strtoul(ms.capture[0].init, (char **)NULL, 10) == cv) {
-    return (int16_t)strtol(ms.capture[1].init, (char **)NULL, 10);
-  }
-  return -1;
+int8_t DCCEx::writeCVBitAsync(uint16_t cv, uint8_t bit, bool value, Callback callback) {
+  int8_t handle = newRequest(RequestType::WRITE_CV_BIT, callback, cv, bit, value);
+  return handle != -1 && send(handle) ? handle : -1;
 }
 
 bool DCCEx::writeCVBit(uint16_t cv, uint8_t bit, bool value) {
-  char buf[25];
-  sprintf_P(buf, PSTR("<B %d %d %d 12345 32767>"), cv, bit, value);
-  _serial->println(buf);
-
-  memset(buf, 0, sizeof(buf));
-  MatchState ms(buf, sizeof(buf));
-  char pattern[33];
-  strncpy_P(pattern, PSTR("<r12345|32767|(%d+) (%d+) (%d+)>"), sizeof(pattern));
-
-  if (readCSResponse(buf, sizeof(buf) - 1) && ms.Match(pattern) == REGEXP_MATCHED &&
-      (uint16_t)strtoul(ms.capture[0].init, (char **)NULL, 10) == cv &&
-      (uint8_t)strtoul(ms.capture[1].init, (char **)NULL, 10) == bit &&
-      (uint8_t)strtoul(ms.capture[2].init, (char **)NULL, 10) == value) {
-    return true;
-  }
-  return false;
+  return wait(writeCVBitAsync(cv, bit, value));
 }
@@ -2,6 +2,21 @@
 #define DCC_EX_H
 
 #include <Arduino.h>
+#include <DCCExParser.h>
+#include <CommandQueue.h>
+#include <CSSerial.h>
+
+/**
+ * @brief CS command dialects, set `DCCEX_PROTOCOL` to one of these in `platformio.ini`
+ * to skip the version check, e.g. `-D DCCEX_PROTOCOL=DCCEX_PROTOCOL_V4`
+ */
+#define DCCEX_PROTOCOL_AUTO 0 // Legacy until `<s>` reports v4 or later
+#define DCCEX_PROTOCOL_LEGACY 1 // `<t 1 cab speed dir>` replied to with `<T 1 speed dir>`
+#define DCCEX_PROTOCOL_V4 2 // `<t cab speed dir>` replied to with `<l cab reg speedByte functMap>`
+
+#ifndef DCCEX_PROTOCOL
+#define DCCEX_PROTOCOL DCCEX_PROTOCOL_AUTO
+#endif
 
 struct TracksEnum {
   enum Tracks : uint8_t {
@@ -12,32 +27,269 @@ struct TracksEnum {
 };
 typedef TracksEnum::Tracks Track;
 
+/**
+ * @brief TX priority lanes, a command is only written when every higher lane is empty
+ */
+struct LanesEnum {
+  enum Lanes : uint8_t {
+    EMERGENCY, // Emergency stop and power off
+    THROTTLE, // Throttle, release and power on
+    FUNCTION, // Loco functions
+    PROGRAM, // PROG track
+    COUNT // Always at end
+  };
+};
+typedef LanesEnum::Lanes Lane;
+
+/**
+ * @brief Types of request that expect a response from the CS
+ */
+struct RequestTypeEnum {
+  enum Types : uint8_t {
+    THROTTLE,
+    WRITE_ADDRESS,
+    READ_ADDRESS,
+    WRITE_CV_BYTE,
+    READ_CV_BYTE,
+    WRITE_CV_BIT,
+    HEARTBEAT,
+    STATUS,
+    COUNT // Always at end
+  };
+};
+typedef RequestTypeEnum::Types RequestType;
+
+/**
+ * @brief Request types grouped by how long the CS takes to respond, each class keeps its own round trip estimate
+ */
+struct RoundTripClassEnum {
+  enum Classes : uint8_t {
+    THROTTLE, // Throttle acknowledgements, a few ms
+    HEARTBEAT, // `<#>` & `<s>` on the function lane, function commands themselves aren't acknowledged
+    ADDRESS, // Address reads & writes, several CV operations on the PROG track
+    CV, // Single CV reads & writes on the PROG track
+    COUNT // Always at end
+  };
+};
+typedef RoundTripClassEnum::Classes RoundTripClass;
+
+/**
+ * @brief Health of the link to the CS
+ */
+struct LinkStateEnum {
+  enum States : uint8_t {
+    CONNECTED, // CS is responding
+    DEGRADED, // A heartbeat has been missed
+    LOST // Several heartbeats have been missed, or the CS hasn't responded since startup
+  };
+};
+typedef LinkStateEnum::States LinkState;
+
+/**
+ * @brief State of a request, returned when polling a request handle
+ */
+struct RequestStateEnum {
+  enum States : uint8_t {
+    FREE, // Slot isn't in use
+    PENDING, // Sent, waiting for the CS response
+    SUCCESS, // CS responded as expected
+    FAILED, // CS responded with an error or the request timed out
+    EXPIRED // Handle is no longer valid, the slot has been reused
+  };
+};
+typedef RequestStateEnum::States RequestState;
+
 class DCCEx  {
-  private:
+  public:
     /**
-     * @brief Pointer to the Serial used
+     * @brief Lambda declaration, called when a request completes
      */
-    HardwareSerial *_serial;
+    using Callback = void(*)(bool success, int16_t value);
     /**
-     * @brief Read the serial buffer until a newline character is found
-     * 
-     * @param buffer Pointer to char array
-     * @param length Size of char array
-     * @return uint16_t 
+     * @brief Lambda declaration, called when the CS broadcasts a loco's state
      */
-    uint16_t readCSResponse(char *buffer, uint16_t length);
-  public:
+    using LocoListener = void(*)(uint16_t address, int8_t speed, uint8_t direction, uint32_t functions);
+    /**
+     * @brief Lambda declaration, called when the CS broadcasts a track power change
+     */
+    using PowerListener = void(*)(Track track, bool on);
+    /**
+     * @brief Lambda declaration, called when the link state changes
+     */
+    using LinkListener = void(*)(LinkState state, LinkState previous);
+    /**
+     * @brief Max requests that can be waiting on a CS response at the same time
+     */
+    static const uint8_t MAX_REQUESTS = 8;
+    /**
+     * @brief Max locos that can have a coalesced throttle change waiting to be sent
+     */
+    static const uint8_t MAX_THROTTLES = 4;
+    /**
+     * @brief Max bytes of lower lane commands left in the serial TX buffer, an emergency stop
+     * only waits for this backlog to go out (~2ms at 115200). A longer command is written once the buffer is empty
+     */
+    static const uint8_t TX_BACKLOG = 24;
+    /**
+     * @brief Time in ms without hearing from the CS before a heartbeat is sent
+     */
+    static const uint16_t HEARTBEAT_INTERVAL = 2000;
+    /**
+     * @brief Missed heartbeats before the link is lost
+     */
+    static const uint8_t HEARTBEAT_MISSES = 3;
+    /**
+     * @brief Frames kept in the trace ring
+     */
+    static const uint8_t TRACE_SIZE = 32;
+    /**
+     * @brief Round trip histogram buckets, bucket `n` counts round trips of 2^(n-1) to 2^n - 1 ms
+     * and the last bucket everything longer
+     */
+    static const uint8_t HISTOGRAM_BUCKETS = 12;
     /**
      * @brief Construct a new `DCCEx` object 
      * 
      * @param serial The serial interface to use
-     * @param timeout Timeout for the serial interface
+     * @param timeout Timeout in ms to wait for a CS response until a round trip has been measured,
+     * limited to each class's floor & ceiling
+     */
+    DCCEx(CSSerial *serial, uint16_t timeout = 5000);
+    /**
+     * @brief Process CS responses and request timeouts, never blocks so needs calling every `loop()`
+     */
+    void loop();
+    /**
+     * @brief Poll the state of an async request
+     * Completed requests stay pollable until their slot is reused
+     * 
+     * @param handle Handle returned by one of the async methods
+     * @param value Optional pointer to store the response value
+     * @return RequestState 
+     */
+    RequestState poll(int8_t handle, int16_t *value = nullptr);
+    /**
+     * @brief Set the listener for `<l cab reg speedByte functMap>` broadcasts
+     * Broadcasts for a loco with a throttle change still in flight are skipped as they'd be out of date
+     * 
+     * @param listener 
+     */
+    void setLocoListener(LocoListener listener);
+    /**
+     * @brief Set the listener for `<p0>` & `<p1>` broadcasts
+     * 
+     * @param listener 
+     */
+    void setPowerListener(PowerListener listener);
+    /**
+     * @brief Is the track powered, as last broadcast by the CS
+     * 
+     * @param track A value from the `Track` enum, `Track::ALL` is true if both are powered
+     * @return true 
+     * @return false 
+     */
+    bool isPowerOn(Track track);
+    /**
+     * @brief Set the listener for link state changes
+     * 
+     * @param listener 
+     */
+    void setLinkListener(LinkListener listener);
+    /**
+     * @brief Get the link state
+     * 
+     * @return LinkState 
+     */
+    LinkState getLinkState();
+    /**
+     * @brief Get the CS major version, from the `<s>` sent at startup and after the link is lost
+     * 
+     * @return uint8_t 0 until the CS has responded
+     */
+    uint8_t getVersion();
+    /**
+     * @brief Are throttle commands using the v4 dialect
+     * Constant unless `DCCEX_PROTOCOL` is `DCCEX_PROTOCOL_AUTO` so the unused dialect is compiled out
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool isV4() {
+      #if DCCEX_PROTOCOL == DCCEX_PROTOCOL_V4
+      return true;
+      #elif DCCEX_PROTOCOL == DCCEX_PROTOCOL_LEGACY
+      return false;
+      #else
+      return _version >= 4;
+      #endif
+    }
+    /**
+     * @brief Get the worst time a command has waited between being queued and written to the serial
+     * 
+     * @param lane A value from the `Lane` enum
+     * @return uint32_t Latency in us
+     */
+    uint32_t getTxLatency(Lane lane);
+    /**
+     * @brief Reset the worst case TX latencies
+     */
+    void resetTxLatency();
+    /**
+     * @brief Get the number of commands dropped because their lane was full
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getTxDropped();
+    /**
+     * @brief Get the smoothed round trip time of a request class
+     * 
+     * @param roundTripClass A value from the `RoundTripClass` enum
+     * @return uint16_t Round trip in ms, 0 if none has been measured
+     */
+    uint16_t getRoundTrip(RoundTripClass roundTripClass);
+    /**
+     * @brief Get the response timeout of a request class, the smoothed round trip plus 4 times its deviation
+     * 
+     * @param roundTripClass A value from the `RoundTripClass` enum
+     * @return uint16_t Timeout in ms
+     */
+    uint16_t getTimeout(RoundTripClass roundTripClass);
+    /**
+     * @brief Get the number of requests resent after timing out
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getRetries();
+    /**
+     * @brief Get the number of requests that have timed out, including those that were then retried
+     * 
+     * @return uint16_t 
      */
-    DCCEx(HardwareSerial *serial, uint16_t timeout = 5000);
+    uint16_t getTimeouts();
     /**
-     * @brief Some CS commands send a response we don't use so we need to clear the input buffer
+     * @brief Get the number of CS frames that matched neither a pending request nor a known broadcast
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getUnmatched();
+    /**
+     * @brief Get a round trip histogram bucket
+     * 
+     * @param type A value from the `RequestType` enum
+     * @param bucket 0 to `HISTOGRAM_BUCKETS` - 1
+     * @return uint16_t Responses in the bucket
+     */
+    uint16_t getHistogram(RequestType type, uint8_t bucket);
+    /**
+     * @brief Write the trace ring, oldest frame first, followed by the histograms and counters
+     * 
+     * @param out e.g. `Serial`
+     */
+    void dumpTrace(Print &out);
+    /**
+     * @brief Clear the trace ring, histograms and counters
      */
-    void clearCSResponse();
+    void resetTrace();
     /**
      * @brief Power off the selected track
      * 
@@ -59,7 +311,17 @@ class DCCEx  {
      */
     void emergencyStopAll();
     /**
-     * @brief Set the speed and direction of the loco at the address
+     * @brief Set the speed and direction of the loco at the address without waiting for the CS
+     * 
+     * @param address Loco address
+     * @param speed Loco speed
+     * @param direction Loco direction
+     * @param callback Optional completion callback
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t setThrottleAsync(uint16_t address, int8_t speed, uint8_t direction, Callback callback = nullptr);
+    /**
+     * @brief Set the speed and direction of the loco at the address, blocks until the CS responds
      * 
      * @param address Loco address
      * @param speed Loco speed
@@ -68,14 +330,37 @@ class DCCEx  {
      * @return false 
      */
     bool setThrottle(uint16_t address, int8_t speed, uint8_t direction);
+    /**
+     * @brief Queue a throttle change, the latest change for a loco replaces any still waiting to be sent
+     * Changes are sent at most once per throttle interval, direction changes and stops are sent straight away
+     * 
+     * @param address Loco address
+     * @param speed Loco speed
+     * @param direction Loco direction
+     */
+    void queueThrottle(uint16_t address, int8_t speed, uint8_t direction);
+    /**
+     * @brief Set the minimum time between throttle commands for a loco
+     * 
+     * @param interval Interval in ms
+     */
+    void setThrottleInterval(uint16_t interval);
+    /**
+     * @brief Get the number of throttle commands saved by coalescing
+     * 
+     * @return uint32_t 
+     */
+    uint32_t getThrottlesSaved();
     /**
      * @brief Toggle the Fn state
      * 
      * @param address Loco address
      * @param fn Loco Fn #
      * @param state Fn state
+     * @return true 
+     * @return false The function lane was full
      */
-    void setFn(uint16_t address, uint16_t fn, bool state);
+    bool setFn(uint16_t address, uint16_t fn, bool state);
     /**
      * @brief Release the loco at address
      * 
@@ -83,7 +368,15 @@ class DCCEx  {
      */
     void release(uint16_t address);
     /**
-     * @brief Write address to the loco on the PROG track
+     * @brief Write address to the loco on the PROG track without waiting for the CS
+     * 
+     * @param address New loco address
+     * @param callback Optional completion callback
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t writeAddressAsync(uint16_t address, Callback callback = nullptr);
+    /**
+     * @brief Write address to the loco on the PROG track, blocks until the CS responds
      * 
      * @param address New loco address
      * @return true 
@@ -91,13 +384,29 @@ class DCCEx  {
      */
     bool writeAddress(uint16_t address);
     /**
-     * @brief Read address from the loco on the PROG track
+     * @brief Read address from the loco on the PROG track without waiting for the CS
+     * 
+     * @param callback Optional completion callback, `value` is the address
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t readAddressAsync(Callback callback = nullptr);
+    /**
+     * @brief Read address from the loco on the PROG track, blocks until the CS responds
      * 
      * @return int16_t 
      */
     int16_t readAddress();
     /**
-     * @brief Write a CV byte value to the loco on the PROG track
+     * @brief Write a CV byte value to the loco on the PROG track without waiting for the CS
+     * 
+     * @param cv CV #
+     * @param value CV value
+     * @param callback Optional completion callback
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t writeCVByteAsync(uint16_t cv, uint8_t value, Callback callback = nullptr);
+    /**
+     * @brief Write a CV byte value to the loco on the PROG track, blocks until the CS responds
      * 
      * @param cv CV #
      * @param value CV value
@@ -106,14 +415,32 @@ class DCCEx  {
      */
     bool writeCVByte(uint16_t cv, uint8_t value);
     /**
-     * @brief Read a CV byte value from the loco on the PROG track
+     * @brief Read a CV byte value from the loco on the PROG track without waiting for the CS
+     * 
+     * @param cv CV #
+     * @param callback Optional completion callback, `value` is the CV value
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t readCVByteAsync(uint16_t cv, Callback callback = nullptr);
+    /**
+     * @brief Read a CV byte value from the loco on the PROG track, blocks until the CS responds
      * 
      * @param cv CV #
      * @return int16_t 
      */
     int16_t readCVByte(uint16_t cv);
     /**
-     * @brief Write a CV bit value to the loco on the PROG track
+     * @brief Write a CV bit value to the loco on the PROG track without waiting for the CS
+     * 
+     * @param cv CV #
+     * @param bit CV bit #
+     * @param value CV bit value
+     * @param callback Optional completion callback
+     * @return int8_t Request handle, -1 if no request slot is free
+     */
+    int8_t writeCVBitAsync(uint16_t cv, uint8_t bit, bool value, Callback callback = nullptr);
+    /**
+     * @brief Write a CV bit value to the loco on the PROG track, blocks until the CS responds
      * 
      * @param cv CV #
      * @param bit CV bit #
@@ -122,6 +449,380 @@ class DCCEx  {
      * @return false 
      */
     bool writeCVBit(uint16_t cv, uint8_t bit, bool value);
+  private:
+    /**
+     * @brief A request waiting on a CS response
+     */
+    struct Request {
+      uint8_t type;
+      uint8_t state = RequestState::FREE;
+      bool sent; // Written to the serial, the timeout starts once sent, one that isn't sent within the class ceiling fails
+      uint8_t generation = 0; // Incremented each time the slot is reused so old handles expire
+      uint8_t seq; // Send order, CS responses arrive in the order commands were sent
+      uint8_t retries; // Times the request has been resent
+      uint16_t args[3]; // Request arguments used to validate the response, throttle requests keep the address in the last
+      int16_t value; // Response value
+      uint32_t sentMillis; // When it was queued until it's sent
+      Callback callback;
+    };
+    /**
+     * @brief Latest throttle change for a loco
+     */
+    struct Throttle {
+      uint16_t address = 0;
+      int8_t speed;
+      uint8_t direction;
+      uint8_t sentDirection; // Direction last sent to the CS
+      bool dirty = false; // Change waiting to be sent
+      uint32_t sentMillis = 0;
+    };
+    /**
+     * @brief A frame sent to or received from the CS
+     */
+    struct TraceEntry {
+      uint32_t micros;
+      char opcode;
+      bool rx; // From the CS
+    };
+    /**
+     * @brief Timeout limits for a `RoundTripClass`
+     */
+    struct RoundTripLimits {
+      uint16_t floor; // Shortest timeout in ms, covers the CS's scheduling jitter
+      uint16_t ceiling; // Longest timeout in ms, including backoff
+      uint8_t retries; // Times a request is resent after timing out
+    };
+    /**
+     * @brief Round trip estimate, scaled so it can be updated with shifts
+     */
+    struct RoundTrip {
+      uint16_t smoothed = 0; // Smoothed round trip in ms * 8, 0 until measured
+      uint16_t deviation = 0; // Mean deviation in ms * 4
+    };
+    /**
+     * @brief Timeout limits, indexed by `RoundTripClass`
+     */
+    static const RoundTripLimits ROUND_TRIP_LIMITS[RoundTripClass::COUNT] PROGMEM;
+    /**
+     * @brief Pointer to the CS serial used
+     */
+    CSSerial *_serial;
+    /**
+     * @brief Storage for the TX lanes
+     */
+    uint8_t _txBuffer[32 + 96 + 64 + 48];
+    /**
+     * @brief TX lanes, indexed by `Lane`
+     */
+    CommandQueue _tx[Lane::COUNT];
+    /**
+     * @brief Worst queued to written time in us per lane
+     */
+    uint32_t _txLatency[Lane::COUNT] = { 0 };
+    /**
+     * @brief Commands dropped because their lane was full
+     */
+    uint16_t _txDropped = 0;
+    /**
+     * @brief Response timeout in ms until a round trip has been measured
+     */
+    uint16_t _timeout;
+    /**
+     * @brief Round trip estimates, indexed by `RoundTripClass`
+     */
+    RoundTrip _roundTrips[RoundTripClass::COUNT];
+    /**
+     * @brief Requests resent after timing out
+     */
+    uint16_t _retries = 0;
+    /**
+     * @brief Requests that have timed out
+     */
+    uint16_t _timeouts = 0;
+    /**
+     * @brief CS frames nothing was waiting for
+     */
+    uint16_t _unmatched = 0;
+    /**
+     * @brief Trace ring, always recording
+     */
+    TraceEntry _trace[TRACE_SIZE];
+    /**
+     * @brief Index the next frame is recorded at
+     */
+    uint8_t _traceHead = 0;
+    /**
+     * @brief Frames in the trace ring
+     */
+    uint8_t _traceCount = 0;
+    /**
+     * @brief Round trip histograms, indexed by `RequestType`
+     */
+    uint16_t _histograms[RequestType::COUNT][HISTOGRAM_BUCKETS];
+    /**
+     * @brief Request slots
+     */
+    Request _requests[MAX_REQUESTS];
+    /**
+     * @brief Next request sequence #
+     */
+    uint8_t _seq = 0;
+    /**
+     * @brief Coalesced throttle slots
+     */
+    Throttle _throttles[MAX_THROTTLES];
+    /**
+     * @brief Minimum time in ms between throttle commands for a loco
+     */
+    uint16_t _throttleInterval = 50;
+    /**
+     * @brief Throttle commands replaced before they were sent
+     */
+    uint32_t _throttlesSaved = 0;
+    /**
+     * @brief Loco broadcast listener
+     */
+    LocoListener _locoListener = nullptr;
+    /**
+     * @brief Power broadcast listener
+     */
+    PowerListener _powerListener = nullptr;
+    /**
+     * @brief Track power state, bit per `Track::MAIN` and `Track::PROG`
+     */
+    uint8_t _power = 0;
+    /**
+     * @brief Link state listener
+     */
+    LinkListener _linkListener = nullptr;
+    /**
+     * @brief Current link state
+     */
+    uint8_t _linkState = LinkState::LOST;
+    /**
+     * @brief Heartbeats missed in a row
+     */
+    uint8_t _heartbeatMisses = 0;
+    /**
+     * @brief Handle of the heartbeat waiting on the CS, -1 if none
+     */
+    int8_t _heartbeat = -1;
+    /**
+     * @brief `millis()` the CS was last heard from or a heartbeat last completed
+     */
+    uint32_t _linkMillis = 0;
+    /**
+     * @brief CS major version, 0 if unknown
+     */
+    uint8_t _version = 0;
+    /**
+     * @brief The CS version needs querying, at startup and when the link comes back
+     */
+    bool _negotiate = true;
+    /**
+     * @brief Handle of the `<s>` waiting on the CS, -1 if none
+     */
+    int8_t _status = -1;
+    /**
+     * @brief CS response parser, fed a byte at a time as they arrive
+     */
+    DCCExParser _parser;
+    /**
+     * @brief Get a free request slot and mark it as pending
+     * Completed slots are reused oldest first, pending slots are never reused
+     * 
+     * @param type A value from the `RequestType` enum
+     * @param callback Completion callback
+     * @param arg0 Request arguments used to validate the response
+     * @param arg1 
+     * @param arg2 
+     * @return int8_t Request handle, -1 if every slot is pending
+     */
+    int8_t newRequest(RequestType type, Callback callback, uint16_t arg0 = 0, uint16_t arg1 = 0, uint16_t arg2 = 0);
+    /**
+     * @brief Queue the command for a request from its arguments, used for the first send and retries
+     * 
+     * @param handle 
+     * @return true 
+     * @return false The lane was full, the request has been freed
+     */
+    bool send(int8_t handle);
+    /**
+     * @brief Resend a request that has timed out, or fail it if it's out of retries or has been superseded
+     * 
+     * @param slot 
+     */
+    void retry(uint8_t slot);
+    /**
+     * @brief Queue `<Opcode arg arg ...>`, the opcode and separators are written at compile time and the
+     * arguments formatted straight into the lane
+     * 
+     * @tparam Opcode Command opcode
+     * @tparam Args Integer arguments
+     * @param lane A value from the `Lane` enum
+     * @param handle Request handle the command belongs to, the request is freed if the lane is full
+     * @param args 
+     * @return true 
+     * @return false The lane was full
+     */
+    template<char Opcode, typename... Args>
+    bool command(Lane lane, int8_t handle, Args... args) {
+      CommandQueue &queue = _tx[lane];
+      queue.begin();
+      queue.put('<');
+      queue.put(Opcode);
+      putArgs(queue, args...);
+      queue.put('>');
+      return commit(lane, handle);
+    }
+    /**
+     * @brief End of the `command()` arguments
+     */
+    void putArgs(CommandQueue &) { }
+    /**
+     * @brief Write the `command()` arguments, each preceded by a space
+     * 
+     * @tparam Arg 
+     * @tparam Rest 
+     * @param queue 
+     * @param arg 
+     * @param rest 
+     */
+    template<typename Arg, typename... Rest>
+    void putArgs(CommandQueue &queue, Arg arg, Rest... rest) {
+      queue.put(' ');
+      queue.putNumber(arg);
+      putArgs(queue, rest...);
+    }
+    /**
+     * @brief Commit the command being written to a lane and start writing it to the serial
+     * 
+     * @param lane A value from the `Lane` enum
+     * @param handle Request handle the command belongs to, the request is freed if the lane is full
+     * @return true 
+     * @return false The lane was full
+     */
+    bool commit(Lane lane, int8_t handle);
+    /**
+     * @brief Queue a command from PROGMEM
+     * 
+     * @param lane A value from the `Lane` enum
+     * @param command Command without the newline
+     * @return true 
+     * @return false The lane was full
+     */
+    bool enqueue(Lane lane, const __FlashStringHelper *command);
+    /**
+     * @brief Write queued commands, highest lane first, for as long as the serial TX buffer has room
+     */
+    void flush();
+    /**
+     * @brief Get the `Request` for a handle
+     * 
+     * @param handle 
+     * @return Request* nullptr if the handle has expired
+     */
+    Request *getRequest(int8_t handle);
+    /**
+     * @brief Complete a request and call its callback
+     * 
+     * @param request 
+     * @param success 
+     * @param value 
+     */
+    void complete(Request &request, bool success, int16_t value);
+    /**
+     * @brief Match a complete CS response to the oldest pending request expecting it
+     * Responses that don't match a pending request are ignored
+     * 
+     * @param frame 
+     * @return true 
+     * @return false No pending request was expecting the frame
+     */
+    bool processResponse(const DCCExFrame &frame);
+    /**
+     * @brief Decode loco and power broadcasts and pass them to their listeners
+     * 
+     * @param frame 
+     * @return true 
+     * @return false The frame isn't a known broadcast
+     */
+    bool processBroadcast(const DCCExFrame &frame);
+    /**
+     * @brief Record a frame in the trace ring
+     * 
+     * @param opcode 
+     * @param rx From the CS
+     */
+    void trace(char opcode, bool rx);
+    /**
+     * @brief Does the loco have a throttle change queued or waiting on the CS
+     * 
+     * @param address 
+     * @param exclude Request slot to ignore, -1 for none
+     * @return true 
+     * @return false 
+     */
+    bool isThrottlePending(uint16_t address, int8_t exclude = -1);
+    /**
+     * @brief Send a queued throttle change
+     * 
+     * @param throttle 
+     * @return true 
+     * @return false No request slot was free, the change stays queued
+     */
+    bool sendThrottle(Throttle &throttle);
+    /**
+     * @brief Get the response timeout for a request, doubled for each retry up to the class ceiling
+     * 
+     * @param request 
+     * @return uint16_t Timeout in ms
+     */
+    uint16_t getTimeout(Request &request);
+    /**
+     * @brief Get the round trip class of a request type
+     * 
+     * @param type A value from the `RequestType` enum
+     * @return RoundTripClass 
+     */
+    RoundTripClass getRoundTripClass(uint8_t type);
+    /**
+     * @brief Add a measured round trip to a class's estimate
+     * 
+     * @param roundTripClass A value from the `RoundTripClass` enum
+     * @param rtt Round trip in ms
+     */
+    void addRoundTrip(RoundTripClass roundTripClass, uint16_t rtt);
+    /**
+     * @brief Send a heartbeat if the CS has been quiet for a while
+     */
+    void heartbeat();
+    /**
+     * @brief Query the CS version with `<s>` if it's needed
+     */
+    void negotiate();
+    /**
+     * @brief Decode a DCC 128 step speed byte, bit 7 is forward, 0 is stop and 1 is emergency stop
+     * 
+     * @param speedByte 
+     * @return uint8_t Speed 0 - 126
+     */
+    static uint8_t decodeSpeed(uint8_t speedByte);
+    /**
+     * @brief Change the link state and notify the listener
+     * 
+     * @param state A value from the `LinkState` enum
+     */
+    void setLinkState(LinkState state);
+    /**
+     * @brief Block until a request completes, the UI won't respond while waiting
+     * 
+     * @param handle 
+     * @param value Optional pointer to store the response value
+     * @return true 
+     * @return false 
+     */
+    bool wait(int8_t handle, int16_t *value = nullptr);
 };
 
 #endif
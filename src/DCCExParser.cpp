@@ -0,0 +1,97 @@
+#include <DCCExParser.h>
+
+bool DCCExParser::parse(char c) {
+  if (c == '<') { // Always start a new frame, a partial frame is dropped
+    _state = State::OPCODE;
+    return false;
+  }
+
+  switch (_state) {
+    case State::IDLE: {
+      return false;
+    }
+    case State::OPCODE: {
+      if (c == '>' || c == ' ' || c == '\n') { // Empty frame
+        _state = State::IDLE;
+        return false;
+      }
+      _frame.opcode = c;
+      _frame.count = 0;
+      _frame.textMask = 0;
+      _state = State::SEPARATOR;
+      return false;
+    }
+    default: break;
+  }
+
+  if (c == '>') { // End of frame
+    if (_state != State::SEPARATOR) {
+      endField();
+    }
+    _state = State::IDLE;
+    return true;
+  } else if (c == ' ' || c == '|') { // Field separators
+    if (_state != State::SEPARATOR) {
+      endField();
+      _state = State::SEPARATOR;
+    }
+  } else if (c == '\n' || c == '\r') { // Frames never span lines
+    _state = State::IDLE;
+  } else if (_state == State::SEPARATOR) {
+    startField(c);
+  } else if (_state == State::NUMBER) {
+    if (c >= '0' && c <= '9') {
+      _digits = true;
+      if (_frame.count < DCCExFrame::MAX_FIELDS) {
+        _frame.fields[_frame.count] = _frame.fields[_frame.count] * 10 + (c - '0');
+      }
+    } else { // Not a number after all, the digits so far are the text's number
+      _state = State::TEXT;
+      _textNumber = _frame.count < DCCExFrame::MAX_FIELDS ? _frame.fields[_frame.count] : 0;
+      _textDigits = _digits ? 0xFF : 0;
+    }
+  } else if (_textDigits != 0xFF) { // Text, only the first run of digits is kept
+    if (c >= '0' && c <= '9') {
+      _textNumber = _textNumber * 10 + (c - '0');
+      _textDigits++;
+    } else if (_textDigits > 0) {
+      _textDigits = 0xFF;
+    }
+  }
+
+  return false;
+}
+
+const DCCExFrame &DCCExParser::frame() const {
+  return _frame;
+}
+
+void DCCExParser::reset() {
+  _state = State::IDLE;
+}
+
+void DCCExParser::startField(char c) {
+  _first = c;
+  _textNumber = 0;
+  _textDigits = 0;
+  _negative = c == '-';
+  _digits = c >= '0' && c <= '9';
+  if (_frame.count < DCCExFrame::MAX_FIELDS) {
+    _frame.fields[_frame.count] = _digits ? c - '0' : 0;
+  }
+  _state = _negative || _digits ? State::NUMBER : State::TEXT;
+}
+
+void DCCExParser::endField() {
+  if (_frame.count < DCCExFrame::MAX_FIELDS) {
+    if (_state == State::TEXT || !_digits) {
+      _frame.textMask |= 1 << _frame.count;
+      _frame.fields[_frame.count] = (uint8_t)_first | (int32_t)_textNumber << 8;
+    } else if (_negative) {
+      _frame.fields[_frame.count] = -_frame.fields[_frame.count];
+    }
+  }
+  if (_frame.count < UINT8_MAX) {
+    _frame.count++;
+  }
+}
@@ -0,0 +1,136 @@
+#ifndef DCC_EX_PARSER_H
+#define DCC_EX_PARSER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief A parsed `<...>` frame from the CS
+ * `<r12345|32767|1 3>` is opcode `r` with the fields 12345, 32767, 1 and 3
+ */
+struct DCCExFrame {
+  /**
+   * @brief Max fields kept per frame, any extra fields are counted but not stored
+   */
+  static const uint8_t MAX_FIELDS = 6;
+  /**
+   * @brief Frame opcode, the first character after `<`
+   */
+  char opcode;
+  /**
+   * @brief Number of fields in the frame
+   */
+  uint8_t count;
+  /**
+   * @brief Bit set for each field that wasn't a number, e.g. `MAIN` in `<p1 MAIN>`
+   */
+  uint8_t textMask;
+  /**
+   * @brief Field values, text fields hold their first character in the low byte and the first number
+   * inside them above it, e.g. `V-4.0.0` is `'V' | 4 << 8`, use `text()` & `textNumber()` to read them
+   */
+  int32_t fields[MAX_FIELDS];
+  /**
+   * @brief Is field `i` present and numeric
+   * 
+   * @param i 
+   * @return true 
+   * @return false 
+   */
+  bool isNumber(uint8_t i) const {
+    return i < count && i < MAX_FIELDS && !(textMask & (1 << i));
+  }
+  /**
+   * @brief First character of text field `i`
+   * 
+   * @param i 
+   * @return char 0 if field `i` isn't present or is a number
+   */
+  char text(uint8_t i) const {
+    return i < count && i < MAX_FIELDS && (textMask & (1 << i)) ? fields[i] & 0xFF : 0;
+  }
+  /**
+   * @brief First number inside text field `i`, e.g. 4 for `V-4.0.0`
+   * 
+   * @param i 
+   * @return uint16_t 0 if there isn't one
+   */
+  uint16_t textNumber(uint8_t i) const {
+    return text(i) ? fields[i] >> 8 : 0;
+  }
+};
+
+class DCCExParser {
+  public:
+    /**
+     * @brief Consume a byte from the CS
+     * 
+     * @param c 
+     * @return true A frame has been completed and can be read with `frame()`
+     * @return false 
+     */
+    bool parse(char c);
+    /**
+     * @brief The last completed frame, only valid until the next call to `parse()`
+     * 
+     * @return const DCCExFrame&
+     */
+    const DCCExFrame &frame() const;
+    /**
+     * @brief Drop any partial frame and wait for the next `<`
+     */
+    void reset();
+  private:
+    /**
+     * @brief Parser states
+     */
+    struct StateEnum {
+      enum States : uint8_t {
+        IDLE, // Waiting for `<`
+        OPCODE, // Next character is the opcode
+        SEPARATOR, // Between fields
+        NUMBER, // Inside a numeric field
+        TEXT // Inside a non numeric field
+      };
+    };
+    typedef StateEnum::States State;
+    /**
+     * @brief Current parser state
+     */
+    uint8_t _state = State::IDLE;
+    /**
+     * @brief Is the current numeric field negative
+     */
+    bool _negative;
+    /**
+     * @brief Has the current numeric field had any digits
+     */
+    bool _digits;
+    /**
+     * @brief First character of the current field
+     */
+    char _first;
+    /**
+     * @brief First number inside the current text field
+     */
+    uint16_t _textNumber;
+    /**
+     * @brief Digits of `_textNumber` seen, 0xFF once it has ended
+     */
+    uint8_t _textDigits;
+    /**
+     * @brief Frame being parsed
+     */
+    DCCExFrame _frame;
+    /**
+     * @brief Start a new field with the character `c`
+     * 
+     * @param c 
+     */
+    void startField(char c);
+    /**
+     * @brief Finish the current field
+     */
+    void endField();
+};
+
+#endif
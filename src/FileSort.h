@@ -0,0 +1,116 @@
+#ifndef FILE_SORT_H
+#define FILE_SORT_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+/**
+ * @brief Heapsort of fixed size records in a file, in place with only a few records held in RAM
+ * 
+ * @tparam T Record type
+ */
+template<typename T>
+class FileSort {
+  public:
+    /**
+     * @brief Does a record sort before another
+     */
+    using Before = bool(*)(const T&, const T&);
+    /**
+     * @brief Construct a new `FileSort` object
+     * 
+     * @param file 
+     * @param offset Where the first record starts
+     * @param before 
+     */
+    FileSort(FatFile &file, uint32_t offset, Before before)
+        : _file(file), _offset(offset), _before(before) { }
+    /**
+     * @brief Sort the records
+     * 
+     * @param count Records in the file
+     */
+    void sort(uint16_t count) {
+      T record;
+
+      // Build a max heap, then repeatedly swap the largest to the end
+      for (uint16_t i = count / 2; i-- > 0;) {
+        read(i, record);
+        siftDown(i, count, record);
+      }
+      for (uint16_t end = count; end-- > 1;) {
+        T largest;
+        read(end, record);
+        read(0, largest);
+        write(end, largest);
+        siftDown(0, end, record);
+      }
+    }
+    /**
+     * @brief Read a record
+     * 
+     * @param i 
+     * @param record 
+     */
+    void read(uint16_t i, T &record) {
+      _file.seekSet(_offset + (uint32_t)i * sizeof(T));
+      _file.read(&record, sizeof(T));
+    }
+    /**
+     * @brief Write a record
+     * 
+     * @param i 
+     * @param record 
+     */
+    void write(uint16_t i, const T &record) {
+      _file.seekSet(_offset + (uint32_t)i * sizeof(T));
+      _file.write(&record, sizeof(T));
+    }
+  private:
+    /**
+     * @brief File being sorted
+     */
+    FatFile &_file;
+    /**
+     * @brief Where the first record starts
+     */
+    uint32_t _offset;
+    /**
+     * @brief Record order
+     */
+    Before _before;
+    /**
+     * @brief Move a record down the heap to where it belongs
+     * 
+     * @param hole Where the record starts
+     * @param n Records in the heap
+     * @param record The record
+     */
+    void siftDown(uint16_t hole, uint16_t n, T &record) {
+      T child;
+      T right;
+      while (true) {
+        uint32_t c = 2UL * hole + 1;
+        if (c >= n) {
+          break;
+        }
+        read(c, child);
+        if (c + 1 < n) {
+          read(c + 1, right);
+          if (_before(child, right)) {
+            c++;
+            child = right;
+          }
+        }
+        if (!_before(record, child)) {
+          break;
+        }
+        // Move the child up into the hole rather than swapping, `record` is only written once
+        write(hole, child);
+        hole = c;
+      }
+      write(hole, record);
+    }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include <FunctionMapCache.h>
+#include <Functions.h>
+
+FunctionMapCache::Entry FunctionMapCache::_entries[FunctionMapCache::MAX_MAPS] = { };
+uint16_t FunctionMapCache::_hits = 0;
+uint16_t FunctionMapCache::_misses = 0;
+
+const uint8_t *FunctionMapCache::find(const char *name, uint32_t stamp, uint16_t &size) {
+  uint32_t hash = key(name);
+  for (uint8_t i = 0; i < MAX_MAPS && _entries[i].layout != nullptr; i++) {
+    if (_entries[i].key == hash && _entries[i].stamp == stamp) {
+      promote(i);
+      _hits++;
+      size = _entries[0].size;
+      return _entries[0].layout;
+    }
+  }
+  _misses++;
+  return nullptr;
+}
+
+void FunctionMapCache::add(const char *name, uint32_t stamp, const uint8_t *layout, uint16_t size) {
+  uint32_t hash = key(name);
+
+  // Drop the older copy of this map, then make room for the new one
+  uint16_t bytes = size;
+  for (uint8_t i = 0; i < MAX_MAPS && _entries[i].layout != nullptr;) {
+    if (_entries[i].key == hash) {
+      delete[] _entries[i].layout;
+      for (uint8_t j = i; j < MAX_MAPS - 1; j++) {
+        _entries[j] = _entries[j + 1];
+      }
+      _entries[MAX_MAPS - 1].layout = nullptr;
+    } else {
+      bytes += _entries[i].size;
+      i++;
+    }
+  }
+  if (size > MAX_BYTES) {
+    return;
+  }
+  for (uint8_t i = MAX_MAPS; i-- > 0;) {
+    if (_entries[i].layout != nullptr && (bytes > MAX_BYTES || i == MAX_MAPS - 1)) {
+      bytes -= _entries[i].size;
+      delete[] _entries[i].layout;
+      _entries[i].layout = nullptr;
+    }
+  }
+
+  // The last entry is free, fill it and bring it to the front
+  Entry &entry = _entries[MAX_MAPS - 1];
+  entry.key = hash;
+  entry.stamp = stamp;
+  entry.size = size;
+  entry.layout = new uint8_t[size];
+  if (entry.layout == nullptr) { // Out of memory, the entry is left empty
+    return;
+  }
+  memcpy(entry.layout, layout, size);
+  promote(MAX_MAPS - 1);
+}
+
+uint16_t FunctionMapCache::getHits() {
+  return _hits;
+}
+
+uint16_t FunctionMapCache::getMisses() {
+  return _misses;
+}
+
+uint32_t FunctionMapCache::key(const char *name) {
+  return fnv1a(FNV_BASIS, name, strlen(name));
+}
+
+void FunctionMapCache::promote(uint8_t i) {
+  Entry entry = _entries[i];
+  for (; i > 0; i--) {
+    _entries[i] = _entries[i - 1];
+  }
+  _entries[0] = entry;
+}
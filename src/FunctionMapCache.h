@@ -0,0 +1,88 @@
+#ifndef FUNCTION_MAP_CACHE_H
+#define FUNCTION_MAP_CACHE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Packed function layouts of the `/fns` maps most recently compiled, so locos sharing a decoder map
+ * don't reopen and parse it. Entries are keyed by the map name's hash and hold the map file's stamp, an edited
+ * map misses and is replaced. Kept in RAM, least recently used dropped first, the throttle has no SPI flash
+ */
+class FunctionMapCache {
+  public:
+    /**
+     * @brief Maps cached
+     */
+    static const uint8_t MAX_MAPS = 3;
+    /**
+     * @brief Heap the cached layouts can use, a larger layout isn't cached
+     */
+    static const uint16_t MAX_BYTES = 768;
+    /**
+     * @brief Find a map's layout and make it the most recently used
+     * 
+     * @param name Map name, as in the loco config
+     * @param stamp Of the map file, see `fileStamp()`
+     * @param size Set to the bytes in the layout
+     * @return const uint8_t* nullptr if it isn't cached or the file has changed
+     */
+    static const uint8_t *find(const char *name, uint32_t stamp, uint16_t &size);
+    /**
+     * @brief Cache a copy of a map's layout, replacing any older one
+     * 
+     * @param name 
+     * @param stamp 
+     * @param layout 
+     * @param size 
+     */
+    static void add(const char *name, uint32_t stamp, const uint8_t *layout, uint16_t size);
+    /**
+     * @brief Maps found in the cache
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getHits();
+    /**
+     * @brief Maps that had to be parsed
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getMisses();
+  private:
+    /**
+     * @brief A cached map
+     */
+    struct Entry {
+      uint32_t key; // FNV-1a of the name
+      uint32_t stamp;
+      uint8_t *layout; // nullptr if unused
+      uint16_t size;
+    };
+    /**
+     * @brief Cached maps, most recently used first
+     */
+    static Entry _entries[MAX_MAPS];
+    /**
+     * @brief Maps found in the cache
+     */
+    static uint16_t _hits;
+    /**
+     * @brief Maps that had to be parsed
+     */
+    static uint16_t _misses;
+    /**
+     * @brief Hash a map name
+     * 
+     * @param name 
+     * @return uint32_t 
+     */
+    static uint32_t key(const char *name);
+    /**
+     * @brief Move an entry to the front, shifting the newer ones down
+     * 
+     * @param i 
+     */
+    static void promote(uint8_t i);
+};
+
+#endif
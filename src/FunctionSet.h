@@ -0,0 +1,84 @@
+#ifndef FUNCTION_SET_H
+#define FUNCTION_SET_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Packed loco function states, a bit per function from F0 to F68
+ */
+struct FunctionSet {
+  /**
+   * @brief Functions per loco, F0 - F68 same as DCC++Ex
+   */
+  static const uint8_t MAX_FUNCTIONS = 69;
+  /**
+   * @brief A bit per function, F0 is bit 0 of byte 0
+   */
+  uint8_t bits[(MAX_FUNCTIONS + 7) / 8] = { 0 };
+  /**
+   * @brief Is the function on
+   * 
+   * @param fn 
+   * @return true 
+   * @return false Off or out of range
+   */
+  bool test(uint8_t fn) const {
+    return fn < MAX_FUNCTIONS && (bits[fn >> 3] & (1 << (fn & 7)));
+  }
+  /**
+   * @brief Set the function state, out of range functions are ignored
+   * 
+   * @param fn 
+   * @param on 
+   */
+  void set(uint8_t fn, bool on) {
+    if (fn < MAX_FUNCTIONS) {
+      uint8_t mask = 1 << (fn & 7);
+      bits[fn >> 3] = on ? bits[fn >> 3] | mask : bits[fn >> 3] & ~mask;
+    }
+  }
+  /**
+   * @brief Toggle the function state
+   * 
+   * @param fn 
+   * @return true The function is now on
+   * @return false The function is now off or out of range
+   */
+  bool toggle(uint8_t fn) {
+    set(fn, !test(fn));
+    return test(fn);
+  }
+  /**
+   * @brief Set F0 - F31 from a 32 bit function map, e.g. from `<l cab reg speedByte functMap>`
+   * F32 and above are left as they are
+   * 
+   * @param functions 
+   */
+  void setLow(uint32_t functions) {
+    for (uint8_t i = 0; i < 4; i++) {
+      bits[i] = functions >> (i * 8);
+    }
+  }
+  /**
+   * @brief Are the same functions on
+   * 
+   * @param other 
+   * @return true 
+   * @return false 
+   */
+  bool operator==(const FunctionSet &other) const {
+    return memcmp(bits, other.bits, sizeof(bits)) == 0;
+  }
+  /**
+   * @brief Do any functions differ
+   * 
+   * @param other 
+   * @return true 
+   * @return false 
+   */
+  bool operator!=(const FunctionSet &other) const {
+    return !(*this == other);
+  }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define FUNCTIONS_H
 
 #include <Arduino.h>
+#include <SdCache.h>
 
 // Division and ceil without needing double
 // https://stackoverflow.com/questions/2745074/fast-ceiling-of-an-integer-division-in-c-c#comment32189462_2745074
@@ -11,10 +12,51 @@
  * 
  * @param i number
  * @param div divide by
- * @return uint8_t 
+ * @return uint16_t 
  */
-inline uint8_t divideAndCeil(uint8_t i, uint8_t div) {
+inline uint16_t divideAndCeil(uint16_t i, uint16_t div) {
   return i / div + (i % div != 0);
 }
 
+/**
+ * @brief FNV-1a hash, pass the previous result to hash more data
+ * 
+ * @param hash Start with `FNV_BASIS`
+ * @param data 
+ * @param size 
+ * @return uint32_t 
+ */
+inline uint32_t fnv1a(uint32_t hash, const void *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ ((const uint8_t *)data)[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Starting value for `fnv1a`
+ */
+const uint32_t FNV_BASIS = 2166136261UL;
+
+/**
+ * @brief Add a file's modified time and size to an FNV-1a hash, changes when the file is edited
+ * Only the directory entry is read, a missing file hashes as zeros so creating it is a change too
+ * 
+ * @param hash 
+ * @param path 
+ * @return uint32_t 
+ */
+inline uint32_t fileStamp(uint32_t hash, const char *path) {
+  dir_t dir;
+  memset(&dir, 0, sizeof(dir));
+  FatFile file;
+  if (SdCache::open(file, path)) {
+    file.dirEntry(&dir);
+    file.close();
+  }
+  hash = fnv1a(hash, &dir.lastWriteDate, sizeof(dir.lastWriteDate));
+  hash = fnv1a(hash, &dir.lastWriteTime, sizeof(dir.lastWriteTime));
+  return fnv1a(hash, &dir.fileSize, sizeof(dir.fileSize));
+}
+
 #endif
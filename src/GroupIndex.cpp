@@ -0,0 +1,220 @@
+#include <GroupIndex.h>
+#include <Functions.h>
+#include <ArduinoJson.h>
+
+const char GroupIndex::PATH[] = "/groups.idx";
+
+GroupIndex::GroupIndex(SdFat *sd, RosterIndex *roster)
+    : _sd(sd), _roster(roster) { }
+
+bool GroupIndex::update() {
+  // Loco names are copied into the index so it's stamped with the `/locos` directory too
+  uint32_t current = fileStamp(_roster->signature(), "/groups.json");
+
+  Header header;
+  File file;
+  bool valid = SdCache::open(file, PATH) && file.read(&header, sizeof(header)) == sizeof(header) &&
+      memcmp_P(header.magic, PSTR("GIDX"), sizeof(header.magic)) == 0 && header.version == VERSION &&
+      header.signature == current && header.groups <= MAX_GROUPS &&
+      file.fileSize() == sizeof(Header) + (uint32_t)header.groups * sizeof(Group) + (uint32_t)header.locos * sizeof(RosterIndex::Entry);
+  file.close();
+
+  if (valid) {
+    _groups = header.groups;
+    _locos = header.locos;
+    return header.valid;
+  }
+  return rebuild(current);
+}
+
+uint8_t GroupIndex::count() {
+  return _groups;
+}
+
+uint8_t GroupIndex::readGroups(uint8_t first, Group *groups, uint8_t n) {
+  if (first >= _groups) {
+    return 0;
+  }
+  if (n > _groups - first) {
+    n = _groups - first;
+  }
+
+  File file;
+  SdCache::open(file, PATH);
+  file.seekSet(sizeof(Header) + (uint32_t)first * sizeof(Group));
+  int bytes = file.read(groups, n * sizeof(Group));
+  file.close();
+  return bytes > 0 ? bytes / sizeof(Group) : 0;
+}
+
+uint16_t GroupIndex::open(uint8_t group) {
+  if (readGroups(group, &_open, 1) != 1) {
+    memset(&_open, 0, sizeof(_open));
+  }
+  return _open.count;
+}
+
+uint8_t GroupIndex::readLocos(uint16_t first, RosterIndex::Entry *entries, uint8_t n) {
+  if (first >= _open.count) {
+    return 0;
+  }
+  if (n > _open.count - first) {
+    n = _open.count - first;
+  }
+
+  File file;
+  SdCache::open(file, PATH);
+  file.seekSet(locoOffset(_open.first + first));
+  int bytes = file.read(entries, n * sizeof(RosterIndex::Entry));
+  file.close();
+  return bytes > 0 ? bytes / sizeof(RosterIndex::Entry) : 0;
+}
+
+bool GroupIndex::rebuild(uint32_t signature) {
+  // Counted first so the loco records can go straight after the group records
+  File json = _sd->open("/groups.json", O_READ);
+  bool valid = json && parse(json, nullptr);
+
+  File file = _sd->open(PATH, O_RDWR | O_CREAT | O_TRUNC);
+
+  // Written with no signature first, so an index cut short by a power loss is rebuilt
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy_P(header.magic, PSTR("GIDX"), sizeof(header.magic));
+  header.version = VERSION;
+  file.write(&header, sizeof(header));
+
+  if (valid) {
+    json.seekSet(0);
+    valid = parse(json, &file);
+  }
+  json.close();
+  if (!valid) {
+    _groups = 0;
+    _locos = 0;
+    file.truncate(sizeof(Header));
+  }
+
+  // Stamped even if it didn't parse, so it isn't parsed again until it's changed
+  header.valid = valid;
+  header.groups = _groups;
+  header.locos = _locos;
+  header.signature = signature;
+  file.seekSet(0);
+  file.write(&header, sizeof(header));
+  file.close();
+  return valid;
+}
+
+bool GroupIndex::parse(FatFile &json, FatFile *index) {
+  uint8_t groups = 0;
+  uint16_t locos = 0;
+  Group group;
+
+  if (skip(json, json.read()) != '{') {
+    return false;
+  }
+  int c = skip(json, json.read());
+  while (c == '"') { // "name": [address, ...]
+    memset(&group, 0, sizeof(group));
+    if (!readString(json, group.name, sizeof(group.name)) ||
+        skip(json, json.read()) != ':' || skip(json, json.read()) != '[') {
+      return false;
+    }
+    group.first = locos;
+
+    c = skip(json, json.read());
+    while (c >= '0' && c <= '9') {
+      uint16_t address = 0;
+      for (; c >= '0' && c <= '9'; c = json.read()) {
+        address = address * 10 + (c - '0');
+      }
+      if (groups < MAX_GROUPS) { // Later groups are only checked
+        if (index != nullptr) {
+          writeLoco(*index, locos, address);
+        }
+        locos++;
+        group.count++;
+      }
+
+      c = skip(json, c);
+      if (c != ',') {
+        break;
+      }
+      c = skip(json, json.read());
+    }
+    if (c != ']') {
+      return false;
+    }
+
+    if (groups < MAX_GROUPS) {
+      if (index != nullptr) {
+        index->seekSet(sizeof(Header) + (uint32_t)groups * sizeof(Group));
+        index->write(&group, sizeof(group));
+      }
+      groups++;
+    }
+
+    c = skip(json, json.read());
+    if (c != ',') {
+      break;
+    }
+    c = skip(json, json.read());
+  }
+
+  _groups = groups;
+  _locos = locos;
+  return c == '}';
+}
+
+void GroupIndex::writeLoco(FatFile &index, uint16_t i, uint16_t address) {
+  RosterIndex::Entry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.address = address;
+
+  char path[32];
+  sprintf_P(path, PSTR("/locos/%u.json"), address);
+  File loco;
+  if (SdCache::open(loco, path)) {
+    StaticJsonDocument<16> filterDoc;
+    filterDoc[F("name")] = true;
+    StaticJsonDocument<64> locoDoc;
+    deserializeJson(locoDoc, loco, DeserializationOption::Filter(filterDoc));
+    strlcpy(entry.name, locoDoc[F("name")] | "", sizeof(entry.name));
+    loco.close();
+  }
+  if (entry.name[0] == '\0') { // No config or name, show the address
+    utoa(address, entry.name, 10);
+  }
+
+  index.seekSet(locoOffset(i));
+  index.write(&entry, sizeof(entry));
+}
+
+uint32_t GroupIndex::locoOffset(uint16_t i) {
+  return sizeof(Header) + (uint32_t)_groups * sizeof(Group) + (uint32_t)i * sizeof(RosterIndex::Entry);
+}
+
+int GroupIndex::skip(FatFile &json, int c) {
+  while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    c = json.read();
+  }
+  return c;
+}
+
+bool GroupIndex::readString(FatFile &json, char *buf, uint8_t size) {
+  uint8_t length = 0;
+  for (int c = json.read(); c != '"'; c = json.read()) {
+    if (c == '\\') { // Escaped character, kept as it is
+      c = json.read();
+    }
+    if (c < 0) {
+      return false;
+    }
+    if (length < size - 1) {
+      buf[length++] = c;
+    }
+  }
+  buf[length] = '\0';
+  return true;
+}
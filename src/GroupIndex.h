@@ -0,0 +1,166 @@
+#ifndef GROUP_INDEX_H
+#define GROUP_INDEX_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <UI.h>
+#include <RosterIndex.h>
+
+/**
+ * @brief Binary index of `groups.json`, the groups in file order then each group's locos with their names
+ * `groups.json` is parsed a character at a time so its size isn't limited by RAM. The index is only rebuilt when
+ * `groups.json` or the `/locos` directory entries change, a page of groups or of a group's locos is a single read
+ */
+class GroupIndex {
+  public:
+    /**
+     * @brief Most groups indexed, the group index has to fit `Resume::group`
+     */
+    static const uint8_t MAX_GROUPS = Resume::NO_GROUP - 1;
+    /**
+     * @brief A group record
+     */
+    struct Group {
+      char name[RosterIndex::NAME_SIZE];
+      uint16_t first; // First loco record
+      uint16_t count; // Loco records
+    };
+    /**
+     * @brief Construct a new `GroupIndex` object
+     * 
+     * @param sd 
+     * @param roster Used for the `/locos` signature
+     */
+    GroupIndex(SdFat *sd, RosterIndex *roster);
+    /**
+     * @brief Check the index against `groups.json` and `/locos`, rebuilding it if either has changed
+     * 
+     * @return true 
+     * @return false `groups.json` is missing or isn't an object of arrays of addresses
+     */
+    bool update();
+    /**
+     * @brief Groups in the index
+     * 
+     * @return uint8_t 
+     */
+    uint8_t count();
+    /**
+     * @brief Read consecutive groups, in file order
+     * 
+     * @param first 
+     * @param groups 
+     * @param n 
+     * @return uint8_t Groups read
+     */
+    uint8_t readGroups(uint8_t first, Group *groups, uint8_t n);
+    /**
+     * @brief Open a group so its locos can be read
+     * 
+     * @param group 
+     * @return uint16_t Locos in the group
+     */
+    uint16_t open(uint8_t group);
+    /**
+     * @brief Read consecutive locos of the open group, in file order
+     * 
+     * @param first 
+     * @param entries 
+     * @param n 
+     * @return uint8_t Locos read
+     */
+    uint8_t readLocos(uint16_t first, RosterIndex::Entry *entries, uint8_t n);
+  private:
+    /**
+     * @brief Index file header, padded to a record
+     */
+    struct Header {
+      char magic[4];
+      uint8_t version;
+      uint8_t valid; // Did `groups.json` parse
+      uint16_t groups;
+      uint32_t signature; // Of `groups.json` and the `/locos` directory entries the index was built from
+      uint16_t locos;
+      uint8_t padding[sizeof(Group) - 14];
+    };
+    /**
+     * @brief Index file
+     */
+    static const char PATH[];
+    /**
+     * @brief Format version, a different version is rebuilt
+     */
+    static const uint8_t VERSION = 2;
+    /**
+     * @brief Pointer to `SdFat` object
+     */
+    SdFat *_sd;
+    /**
+     * @brief Pointer to the `RosterIndex`
+     */
+    RosterIndex *_roster;
+    /**
+     * @brief Groups in the index
+     */
+    uint8_t _groups = 0;
+    /**
+     * @brief Loco records in the index
+     */
+    uint16_t _locos = 0;
+    /**
+     * @brief The open group
+     */
+    Group _open = { };
+    /**
+     * @brief Rebuild the index from `groups.json`
+     * 
+     * @param signature 
+     * @return true 
+     * @return false `groups.json` didn't parse
+     */
+    bool rebuild(uint32_t signature);
+    /**
+     * @brief Parse `groups.json`, counting the groups and locos or writing their records
+     * 
+     * @param json 
+     * @param index Where to write the records, nullptr to only count
+     * @return true 
+     * @return false It isn't an object of arrays of addresses
+     */
+    bool parse(FatFile &json, FatFile *index);
+    /**
+     * @brief Write a loco record, named from its config
+     * 
+     * @param index 
+     * @param i 
+     * @param address 
+     */
+    void writeLoco(FatFile &index, uint16_t i, uint16_t address);
+    /**
+     * @brief Where a loco record starts
+     * 
+     * @param i 
+     * @return uint32_t 
+     */
+    uint32_t locoOffset(uint16_t i);
+    /**
+     * @brief Skip whitespace
+     * 
+     * @param json 
+     * @param c The current character
+     * @return int The first character that isn't whitespace, -1 at the end of the file
+     */
+    static int skip(FatFile &json, int c);
+    /**
+     * @brief Read a string up to its closing quote, the opening quote has been read
+     * 
+     * @param json 
+     * @param buf Truncated if the string is longer
+     * @param size 
+     * @return true 
+     * @return false The file ended first
+     */
+    static bool readString(FatFile &json, char *buf, uint8_t size);
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include <Journal.h>
+#include <util/crc16.h>
+
+Journal::Journal() {
+  memset(_positions, NONE, sizeof(_positions));
+}
+
+int8_t Journal::restore(LocoTable &locos) {
+  // Newest valid record, the ring is written in order so the record after it is the oldest
+  Record record;
+  int16_t newest = -1;
+  for (uint8_t i = 0; i < RECORDS; i++) {
+    if (read(i, record) && (newest == -1 || (int16_t)(record.seq - _seq) > 0)) {
+      newest = i;
+      _seq = record.seq;
+    }
+  }
+  if (newest == -1) { // Blank, `_sinceSnapshot` starts full so a snapshot is written straight away
+    return -1;
+  }
+  _head = (newest + 1) % RECORDS;
+  _seq++;
+
+  // Start of the last snapshot that has an end
+  int16_t start = -1;
+  int16_t complete = -1;
+  for (uint8_t n = 0; n < RECORDS; n++) {
+    if (read((_head + n) % RECORDS, record)) {
+      if (record.type == RecordType::SNAPSHOT) {
+        start = n;
+      } else if (record.type == RecordType::SNAPSHOT_END && start != -1) {
+        complete = start;
+      }
+    }
+  }
+  if (complete == -1) {
+    return -1;
+  }
+
+  // Replay from the snapshot, any later incomplete snapshot is just more changes
+  for (uint8_t n = complete; n < RECORDS; n++) {
+    uint8_t i = (_head + n) % RECORDS;
+    if (!read(i, record)) {
+      continue;
+    }
+
+    if (record.type == RecordType::LOCO) {
+      int8_t slot = locos.get(record.address);
+      if (slot != -1) {
+        locos[slot].direction = record.direction;
+        memcpy(locos[slot].functions.bits, record.functions, sizeof(record.functions));
+        _positions[slot] = i;
+      }
+    } else if (record.type == RecordType::FREE) {
+      int8_t slot = locos.find(record.address);
+      if (slot != -1) {
+        locos.free(slot);
+        _positions[slot] = NONE;
+      }
+    } else if (record.type == RecordType::ACTIVE) {
+      _active = record.address;
+    }
+  }
+  _sinceSnapshot = RECORDS - complete;
+
+  return locos.find(_active);
+}
+
+void Journal::loop(LocoTable &locos, uint16_t activeAddress) {
+  if (_written < sizeof(Record)) {
+    // A byte takes 3.3ms to write, only start one when the last has finished
+    if (eeprom_is_ready()) {
+      eeprom_update_byte(location(_head) + _written, ((uint8_t *)&_record)[_written]);
+      if (++_written == sizeof(Record)) {
+        _head = (_head + 1) % RECORDS;
+        _seq++;
+        _sinceStart++;
+        if (_sinceSnapshot < RECORDS) {
+          _sinceSnapshot++;
+        }
+        if (_record.type == RecordType::SNAPSHOT_END) {
+          _sinceSnapshot = _sinceStart;
+        }
+      }
+    }
+    return;
+  }
+
+  // Snapshot before the ring wraps onto the last complete one
+  if (_snapshot != 0 || _sinceSnapshot >= RECORDS - SNAPSHOT_RECORDS) {
+    snapshot(locos, activeAddress);
+    return;
+  }
+
+  if (_scan == LocoTable::MAX_LOCOS) { // Start a new pass once the interval is up
+    if (millis() - _scanMillis < SAVE_INTERVAL) {
+      return;
+    }
+    _scanMillis = millis();
+    _scan = 0;
+
+    if (activeAddress != _active) {
+      _active = activeAddress;
+      append(RecordType::ACTIVE, activeAddress);
+      return;
+    }
+  }
+
+  check(locos);
+}
+
+void Journal::check(LocoTable &locos) {
+  uint8_t slot = _scan;
+  if (release(locos, slot)) {
+    return; // Checked again next call in case it's been reused
+  }
+
+  LocoState &loco = locos[slot];
+  Record journaled;
+  bool hasRecord = _positions[slot] != NONE && read(_positions[slot], journaled);
+  _scan++;
+  if (loco.address != 0 && (!hasRecord || journaled.direction != loco.direction ||
+      memcmp(journaled.functions, loco.functions.bits, sizeof(journaled.functions)) != 0)) {
+    _positions[slot] = _head;
+    append(RecordType::LOCO, loco.address, &loco);
+  }
+}
+
+void Journal::snapshot(LocoTable &locos, uint16_t activeAddress) {
+  if (_snapshot == 0) {
+    _snapshot = 1;
+    _sinceStart = 0;
+    _snapshotReleases = 0;
+    append(RecordType::SNAPSHOT, 0);
+    return;
+  }
+
+  // Until this snapshot ends a restore replays from the last complete one, so releases are journaled as they happen.
+  // There's only room in the ring for a release per slot, any more are journaled once it ends
+  for (uint8_t slot = 0; slot < LocoTable::MAX_LOCOS && _snapshotReleases < LocoTable::MAX_LOCOS; slot++) {
+    if (release(locos, slot)) {
+      _snapshotReleases++;
+      return;
+    }
+  }
+
+  // By slot rather than active position, positions move when a loco is released
+  while (_snapshot <= LocoTable::MAX_LOCOS) {
+    uint8_t slot = _snapshot++ - 1;
+    if (locos[slot].address != 0) {
+      _positions[slot] = _head;
+      append(RecordType::LOCO, locos[slot].address, &locos[slot]);
+      return;
+    }
+    _positions[slot] = NONE;
+  }
+
+  if (_snapshot == LocoTable::MAX_LOCOS + 1) {
+    _snapshot++;
+    _active = activeAddress;
+    append(RecordType::ACTIVE, activeAddress);
+  } else {
+    _snapshot = 0;
+    append(RecordType::SNAPSHOT_END, 0);
+  }
+}
+
+bool Journal::release(LocoTable &locos, uint8_t slot) {
+  Record journaled;
+  if (_positions[slot] == NONE || !read(_positions[slot], journaled) || journaled.address == locos[slot].address) {
+    return false;
+  }
+  // Released, or reused for another loco
+  _positions[slot] = NONE;
+  append(RecordType::FREE, journaled.address);
+  return true;
+}
+
+void Journal::append(RecordType type, uint16_t address, LocoState *loco) {
+  _record.seq = _seq;
+  _record.address = address;
+  _record.type = type;
+  _record.direction = loco != nullptr ? loco->direction : 0;
+  if (loco != nullptr) {
+    memcpy(_record.functions, loco->functions.bits, sizeof(_record.functions));
+  } else {
+    memset(_record.functions, 0, sizeof(_record.functions));
+  }
+  _record.crc = crc(_record);
+  _written = 0;
+}
+
+bool Journal::read(uint8_t index, Record &record) {
+  eeprom_read_block(&record, location(index), sizeof(Record));
+  return record.type >= RecordType::SNAPSHOT && record.type <= RecordType::ACTIVE && record.crc == crc(record);
+}
+
+uint8_t *Journal::location(uint8_t index) {
+  return (uint8_t *)(START + index * sizeof(Record));
+}
+
+uint8_t Journal::crc(const Record &record) {
+  uint8_t crc = 0;
+  const uint8_t *bytes = (const uint8_t *)&record;
+  for (uint8_t i = 0; i < sizeof(Record) - 1; i++) {
+    crc = _crc8_ccitt_update(crc, bytes[i]);
+  }
+  return crc;
+}
@@ -0,0 +1,182 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <LocoTable.h>
+
+/**
+ * @brief Append only journal of acquired locos in EEPROM, restored after a power cycle
+ * Records are written round a ring of fixed size slots so wear is spread over the whole EEPROM,
+ * a snapshot of every loco is written before the ring wraps onto the last one so the ring always
+ * holds a complete state. Speed isn't saved so locos come back stopped
+ */
+class Journal {
+  public:
+    /**
+     * @brief Minimum time in ms between checks for changes, changes within it share a record
+     */
+    static const uint16_t SAVE_INTERVAL = 2000;
+    /**
+     * @brief Construct a new `Journal` object
+     */
+    Journal();
+    /**
+     * @brief Restore the locos and active loco from the journal
+     * 
+     * @param locos 
+     * @return int8_t Active loco slot, -1 if there isn't one
+     */
+    int8_t restore(LocoTable &locos);
+    /**
+     * @brief Journal any changes, never blocks as only a byte is written per call
+     * 
+     * @param locos 
+     * @param activeAddress Address of the active loco, 0 if none
+     */
+    void loop(LocoTable &locos, uint16_t activeAddress);
+  private:
+    /**
+     * @brief Record types
+     */
+    struct RecordTypeEnum {
+      enum Types : uint8_t {
+        SNAPSHOT = 1, // Start of a snapshot, the state is rebuilt from the last complete one
+        SNAPSHOT_END, // Snapshot is complete
+        LOCO, // Loco acquired or its direction or functions changed
+        FREE, // Loco released
+        ACTIVE // Active loco changed, address 0 if none
+      };
+    };
+    typedef RecordTypeEnum::Types RecordType;
+    /**
+     * @brief A journal entry, the CRC is written last so a record cut short by a power loss is invalid
+     */
+    struct Record {
+      uint16_t seq; // Incremented for each record, finds the newest after a restart
+      uint16_t address;
+      uint8_t type;
+      uint8_t direction;
+      uint8_t functions[sizeof(FunctionSet::bits)];
+      uint8_t crc; // CRC-8 of the bytes before it
+    };
+    /**
+     * @brief First EEPROM byte used, the bytes before are settings, e.g. rotation at 0
+     */
+    static const uint16_t START = 16;
+    /**
+     * @brief Records that fit in the ring
+     */
+    static const uint8_t RECORDS = (E2END + 1 - START) / sizeof(Record);
+    /**
+     * @brief Records a snapshot can take, start, every loco, up to a release per slot while it's written, active and end
+     */
+    static const uint8_t SNAPSHOT_RECORDS = LocoTable::MAX_LOCOS * 2 + 3;
+    /**
+     * @brief Marks a slot without a record
+     */
+    static const uint8_t NONE = 0xFF;
+    /**
+     * @brief Record being written
+     */
+    Record _record;
+    /**
+     * @brief Next byte of `_record` to write, `sizeof(Record)` when idle
+     */
+    uint8_t _written = sizeof(Record);
+    /**
+     * @brief Ring index `_record` is written to
+     */
+    uint8_t _head = 0;
+    /**
+     * @brief Sequence # of the next record
+     */
+    uint16_t _seq = 0;
+    /**
+     * @brief Records written since the start of the last complete snapshot
+     */
+    uint8_t _sinceSnapshot = RECORDS;
+    /**
+     * @brief Records written since the start of the snapshot being written
+     */
+    uint8_t _sinceStart = 0;
+    /**
+     * @brief Next snapshot step, 1 - `MAX_LOCOS` are slots then active and end, 0 when not writing one
+     */
+    uint8_t _snapshot = 0;
+    /**
+     * @brief `FREE` records written since the start of the snapshot being written
+     */
+    uint8_t _snapshotReleases = 0;
+    /**
+     * @brief Ring index of each loco slot's latest record, `NONE` if it hasn't been journaled
+     */
+    uint8_t _positions[LocoTable::MAX_LOCOS];
+    /**
+     * @brief Active loco address last journaled
+     */
+    uint16_t _active = 0;
+    /**
+     * @brief Next loco slot to check
+     */
+    uint8_t _scan = LocoTable::MAX_LOCOS;
+    /**
+     * @brief `millis()` of the last check for changes
+     */
+    uint32_t _scanMillis = 0;
+    /**
+     * @brief Start writing a record at the head of the ring
+     * 
+     * @param type A value from the `RecordType` enum
+     * @param address 
+     * @param loco Direction & functions to save, nullptr for none
+     */
+    void append(RecordType type, uint16_t address, LocoState *loco = nullptr);
+    /**
+     * @brief Start writing the next snapshot record
+     * 
+     * @param locos 
+     * @param activeAddress 
+     */
+    void snapshot(LocoTable &locos, uint16_t activeAddress);
+    /**
+     * @brief Start writing a `FREE` record if a slot's journaled loco has been released or replaced
+     * 
+     * @param locos 
+     * @param slot 
+     * @return true A record was started
+     * @return false 
+     */
+    bool release(LocoTable &locos, uint8_t slot);
+    /**
+     * @brief Start writing a record if the next slot to check differs from its journaled state
+     * 
+     * @param locos 
+     */
+    void check(LocoTable &locos);
+    /**
+     * @brief Read a record from the ring
+     * 
+     * @param index 
+     * @param record 
+     * @return true 
+     * @return false The record is blank or corrupt
+     */
+    bool read(uint8_t index, Record &record);
+    /**
+     * @brief EEPROM address of a ring index
+     * 
+     * @param index 
+     * @return uint8_t* 
+     */
+    uint8_t *location(uint8_t index);
+    /**
+     * @brief CRC-8 of a record, excluding its CRC byte
+     * 
+     * @param record 
+     * @return uint8_t 
+     */
+    static uint8_t crc(const Record &record);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <JsonArena.h>
+
+uint8_t *JsonArena::_pool = nullptr;
+uint16_t JsonArena::_peak = 0;
+uint16_t JsonArena::_failures = 0;
+
+void *JsonArena::Allocator::allocate(size_t size) {
+  if (_pool != nullptr || size > SIZE) {
+    return nullptr;
+  }
+  _pool = (uint8_t*)malloc(SIZE); // nullptr if the heap is too fragmented, the document reports `NoMemory`
+  return _pool;
+}
+
+void JsonArena::Allocator::deallocate(void *pointer) {
+  if (pointer != nullptr && pointer == _pool) {
+    free(_pool);
+    _pool = nullptr;
+  }
+}
+
+void *JsonArena::Allocator::reallocate(void *pointer, size_t size) {
+  // Shrinking is free, the arena is lent whole
+  return pointer != nullptr && pointer == _pool && size <= SIZE ? pointer : nullptr;
+}
+
+uint16_t JsonArena::getPeak() {
+  return _peak;
+}
+
+uint16_t JsonArena::getFailures() {
+  return _failures;
+}
+
+ArenaDocument::ArenaDocument()
+    : BasicJsonDocument<JsonArena::Allocator>(JsonArena::SIZE) {
+  if (capacity() == 0) { // Another document has the arena or it couldn't be allocated, every read will fail
+    _error = DeserializationError::NoMemory;
+    JsonArena::_failures++;
+  }
+}
+
+ArenaDocument::~ArenaDocument() {
+  getPeak();
+}
+
+bool ArenaDocument::read(FatFile &file) {
+  _error = deserializeJson(*this, file);
+  getPeak();
+  if (_error) {
+    clear();
+    JsonArena::_failures++;
+  }
+  return !_error;
+}
+
+DeserializationError ArenaDocument::getError() {
+  if (!_error && overflowed()) {
+    _error = DeserializationError::NoMemory;
+    JsonArena::_failures++;
+  }
+  return _error;
+}
+
+uint16_t ArenaDocument::getPeak() {
+  _peak = max(_peak, (uint16_t)memoryUsage());
+  JsonArena::_peak = max(JsonArena::_peak, _peak);
+  return _peak;
+}
@@ -0,0 +1,100 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief Memory shared by the JSON documents, allocated while a document borrows it and freed when it's returned
+ * Documents are only parsed to compile a loco config, so the arena isn't kept in RAM the rest of the time.
+ * Only one document can borrow the arena at a time, a second one gets no memory and fails to parse
+ */
+class JsonArena {
+  public:
+    /**
+     * @brief Arena size in bytes, the loco document size the `Loco` UI used to keep
+     */
+    static const uint16_t SIZE = 4096;
+    /**
+     * @brief ArduinoJson allocator that lends out the whole arena
+     */
+    struct Allocator {
+      void *allocate(size_t size);
+      void deallocate(void *pointer);
+      void *reallocate(void *pointer, size_t size);
+    };
+    /**
+     * @brief Most arena memory any document has used
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getPeak();
+    /**
+     * @brief Documents that didn't fit the arena, couldn't allocate it or failed to parse
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getFailures();
+  private:
+    friend class ArenaDocument;
+    /**
+     * @brief The arena, nullptr unless it's borrowed
+     */
+    static uint8_t *_pool;
+    /**
+     * @brief Most arena memory any document has used
+     */
+    static uint16_t _peak;
+    /**
+     * @brief Documents that didn't fit the arena, couldn't allocate it or failed to parse
+     */
+    static uint16_t _failures;
+};
+
+/**
+ * @brief JSON document that borrows the `JsonArena` while it's in scope
+ * A document that doesn't fit is emptied and reports an error rather than being used truncated
+ */
+class ArenaDocument : public BasicJsonDocument<JsonArena::Allocator> {
+  public:
+    /**
+     * @brief Construct a new `ArenaDocument` object, borrowing the arena
+     */
+    ArenaDocument();
+    /**
+     * @brief Destroy the `ArenaDocument` object, returning the arena
+     */
+    ~ArenaDocument();
+    /**
+     * @brief Parse a JSON file into the document
+     * 
+     * @param file 
+     * @return true 
+     * @return false The file didn't parse or fit, the document is left empty
+     */
+    bool read(FatFile &file);
+    /**
+     * @brief Error from the last read, or `NoMemory` if anything added since overflowed the arena
+     * 
+     * @return DeserializationError 
+     */
+    DeserializationError getError();
+    /**
+     * @brief Most memory used by this document
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getPeak();
+  private:
+    /**
+     * @brief Error from the last read
+     */
+    DeserializationError _error;
+    /**
+     * @brief Most memory used by this document
+     */
+    uint16_t _peak = 0;
+};
+
+#endif
@@ -105,8 +105,7 @@ int8_t KeyPad::touch(uint16_t x, uint16_t y, Touched touch) {
     while (touch()) {
       delay(50);
     }
-    uint16_t valid = getNumber();
-    if (valid >= _min && valid <= _max) {
+    if (accept()) {
       return KeyPadButton::ENTER;
     }
     _enter->draw();
@@ -121,6 +120,7 @@ int8_t KeyPad::touch(uint16_t x, uint16_t y, Touched touch) {
     if (len > 0) {
       _numberBuf[len - 1] = '\0';
       printNumber();
+      changed();
     }
   } else if (_clear->contains(x, y)) { // Clear
     _clear->draw(true);
@@ -131,6 +131,7 @@ int8_t KeyPad::touch(uint16_t x, uint16_t y, Touched touch) {
 
     memset(_numberBuf, 0, sizeof(_numberBuf));
     printNumber();
+    changed();
   } else { // Number buttons
     for (uint8_t i = 0; i < 10; i++) {
       if (_numberBtns[i]->contains(x, y)) {
@@ -145,9 +146,9 @@ int8_t KeyPad::touch(uint16_t x, uint16_t y, Touched touch) {
           _numberBuf[len] = _numberBtnLabels[i][0];
         }
  
-        uint32_t valid = getNumber();
-        if (valid >= _min && valid <= _max) {
+        if (accept()) {
           printNumber();
+          changed();
         } else {
           _numberBuf[len] = '\0';
         }
@@ -163,6 +164,17 @@ uint32_t KeyPad::getNumber() {
   return strtoul(_numberBuf, (char **)NULL, 10);
 }
 
+const char *KeyPad::getDigits() {
+  return _numberBuf;
+}
+
+bool KeyPad::accept() {
+  uint32_t number = getNumber();
+  return number >= _min && number <= _max;
+}
+
+void KeyPad::changed() { }
+
 void KeyPad::printNumber() {
   _tft->fillRect(2, 32, 236, 36, ILI9341_BLACK);
   _tft->setCursor(10, 56);
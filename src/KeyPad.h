@@ -56,6 +56,24 @@ class KeyPad : public UI {
      * @return uint32_t 
      */
     uint32_t getNumber();
+    /**
+     * @brief Get the digits entered
+     * 
+     * @return const char* 
+     */
+    const char *getDigits();
+  protected:
+    /**
+     * @brief Can the digits entered be kept, or entered with the enter button
+     * 
+     * @return true The number is in range
+     * @return false 
+     */
+    virtual bool accept();
+    /**
+     * @brief The digits entered have changed
+     */
+    virtual void changed();
   private:
     /**
      * @brief `KeyPad` title
@@ -86,9 +104,9 @@ class KeyPad : public UI {
      */
     TouchButton *_clear;
     /**
-     * @brief Number buffer, max 6 digits
+     * @brief Number buffer, max 13 digits
      */
-    char _numberBuf[6] = { 0 };
+    char _numberBuf[14] = { 0 };
     /**
      * @brief `TouchButtons`s for 0-9
      */
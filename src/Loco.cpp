@@ -2,33 +2,12 @@
 #include <Adafruit_ILI9341.h>
 #include <Functions.h>
 
-Loco::Loco(Adafruit_SPITFT *tft, SdFat *sd, DCCEx *dcc, LocoState *loco)
-    : UI(tft), _sd(sd), _dcc(dcc), _loco(loco) {
-  char path[32];
-  sprintf_P(path, PSTR("/locos/%d.json"), _loco->address);
-  
-  if (_sd->exists(path)) { // Check for loco config file
-    FatFile json = _sd->open(path);
-    deserializeJson(_locoDoc, json);
-    json.close();
-  }
-  
+Loco::Loco(Adafruit_SPITFT *tft, SdFat *sd, DCCEx *dcc, LocoState *loco, LocoProfile *profile, Resume resume)
+    : UI(tft), _dcc(dcc), _loco(loco), _profile(profile) {
   // Create an Adafruit Image Reader instance to handle buttons with icons
-  _imageReader = new Adafruit_ImageReader(*_sd);
+  _imageReader = new Adafruit_ImageReader(*sd);
 
-  // Print the loco name as provided by the config defaulting to `Unknown`
-  _tft->setTextColor(ILI9341_WHITE);
-  _tft->setCursor(0, 12);
-  if (_locoDoc.containsKey(F("name"))) {
-    _tft->println(_locoDoc[F("name")].as<const char*>());
-  } else {
-    _tft->println(F("Unknown"));
-  }
-  
-  // Print the loco address
-  _tft->setCursor(0, 32);
-  _tft->print(F("Address: "));
-  _tft->println(_loco->address);
+  printName();
 
   // Print the loco speed
   _tft->setCursor(0, 52);
@@ -40,39 +19,7 @@ Loco::Loco(Adafruit_SPITFT *tft, SdFat *sd, DCCEx *dcc, LocoState *loco)
   _tft->println(F("Direction:"));
   printDirection();
 
-  if (_locoDoc[F("functions")].is<JsonArray>()) { // Function map array in loco config json
-    _locoFunctions = _locoDoc[F("functions")].as<JsonArray>();
-  } else if (_locoDoc[F("functions")].is<const char*>()) { // Name of function map file
-    sprintf_P(path, PSTR("/fns/%s.json"), _locoDoc[F("functions")].as<const char*>());
-    FatFile json = _sd->open(path);
-    deserializeJson(_locoDoc, json);
-    _locoFunctions = _locoDoc.as<JsonArray>();
-    json.close();
-  }
-
-  uint8_t rows = _locoFunctions.size();
-  if (rows == 0) { // Create 29 default functions if none were specified
-    _locoFunctions = _locoDoc.createNestedArray();
-    char buf[4];
-    JsonArray row;
-    for (uint8_t i = 0; i < 29; i++) {
-      if (i % 3 == 0) { // New row
-        row = _locoFunctions.createNestedArray();
-      }
-      JsonObject fn = row.createNestedObject();
-      sprintf_P(buf, PSTR("F%d"), i);
-      fn[F("label")] = buf;
-      fn[F("fn")] = i;
-      // TODO, which Fn's are by default non latching?
-    }
-    rows = 10;
-  }
-
-  if (rows > 7) { // More than 7 rows and we need paging
-    uint8_t pages = divideAndCeil(rows, 6);
-    _paging = new Paging(_tft, pages);
-  }
-
+  createPaging(resume.page);
   drawFunctionButtons();
 }
 
@@ -88,9 +35,29 @@ void Loco::destroyFunctionButtons() {
     delete _locoFunctionBtns[i];
   }
   delete[] _locoFunctionBtns;
+  TouchButton::unpinIcons(); // Their icons can be replaced by the next page's
+}
+
+void Loco::printName() {
+  // Print the loco name as provided by the config defaulting to `Unknown`
+  _tft->setTextColor(ILI9341_WHITE);
+  _tft->setCursor(0, 12);
+  if (_profile == nullptr) { // Couldn't be loaded, shown without functions
+    _tft->println(F("Out of memory"));
+  } else if (_profile->getName() != nullptr) {
+    _tft->println(_profile->getName());
+  } else {
+    _tft->println(F("Unknown"));
+  }
+  
+  // Print the loco address
+  _tft->setCursor(0, 32);
+  _tft->print(F("Address: "));
+  _tft->println(_loco->address);
 }
 
 void Loco::printSpeed() {
+  _shownSpeed = _loco->speed;
   _tft->fillRect(60, 38, 40, 16, ILI9341_BLACK);
   _tft->setTextColor(ILI9341_WHITE);
   _tft->setCursor(60, 52);
@@ -98,21 +65,37 @@ void Loco::printSpeed() {
 }
 
 void Loco::printDirection() {
+  _shownDirection = _loco->direction;
   _tft->fillRect(200, 38, 40, 16, ILI9341_BLACK);
   _tft->setTextColor(ILI9341_WHITE);
   _tft->setCursor(200, 52);
   _tft->print(_loco->direction == Direction::FORWARD ? F("FWD") : F("REV"));
 }
 
-void Loco::drawFunctionButtons() {
-  _tft->fillRect(0, 60, 240, 228, ILI9341_BLACK); // Clear buttons
+void Loco::createPaging(uint16_t page) {
+  uint8_t rows = _profile != nullptr ? _profile->getRows() : 0;
+  if (rows > 7) { // More than 7 rows and we need paging
+    uint8_t pages = divideAndCeil(rows, 6);
+    _paging = new Paging(_tft, pages, page);
+  }
+}
+
+void Loco::drawFunctionButtons(bool all) {
+  if (all) {
+    _tft->fillRect(0, 60, 240, 228, ILI9341_BLACK); // Clear buttons
+  }
   
-  uint8_t i = 0;
   _locoFunctionCount = 0;
+  _locoFunctionBtns = nullptr;
+  if (_profile == nullptr) {
+    return;
+  }
+
+  uint8_t rows = _profile->getRows();
   // Get the function button count
-  for (JsonArrayConst const& row : _locoFunctions) {
-    if (_paging == nullptr || divideAndCeil(++i, 6) == _paging->getPage()) {
-      _locoFunctionCount += row.size();
+  for (uint8_t row = 0; row < rows; row++) {
+    if (_paging == nullptr || divideAndCeil(row + 1, 6) == _paging->getPage()) {
+      _locoFunctionCount += _profile->getColumns(row);
     }
   }
 
@@ -120,55 +103,58 @@ void Loco::drawFunctionButtons() {
 
   uint8_t btn = 0;
   uint16_t y = 60; // Start at 90
-  i = 0;
-  for (JsonArrayConst const& row : _locoFunctions) {
-    if (_paging == nullptr || divideAndCeil(++i, 6) == _paging->getPage()) {
-      uint8_t cols = row.size();
-      uint8_t width = (240 - ((cols - 1) * 6)) / cols;
-
-      uint8_t x = 0;
-      uint8_t col = 0;
-      for (JsonObjectConst const& fn : row) {
-        JsonObjectConst idle = fn[F("btn")][F("idle")];
-        JsonObjectConst pressed = fn[F("btn")][F("pressed")];
-        // Needed for 4 button rows as it divides to a half pixel so the two inner buttons are 1 pixel wider
-        uint8_t extra = cols == 4 && (col == 1 || col == 2) ? 1 : 0;
-        _locoFunctionBtns[btn] = new FunctionButton(_tft, _imageReader, x, y, width + extra, 32, fn[F("label")], {
-          ILI9341_WHITE,
-          idle[F("fill")] | (uint16_t)ILI9341_BLACK,
-          idle[F("text")] | (uint16_t)ILI9341_WHITE,
-          idle[F("icon")]
-        }, {
-          ILI9341_WHITE,
-          pressed[F("fill")] | (uint16_t)ILI9341_WHITE,
-          pressed[F("text")] | (uint16_t)ILI9341_BLACK,
-          pressed[F("icon")]
-        }, fn[F("fn")], fn[F("latching")] | true);
-
-        uint32_t funcmask = (1UL << _locoFunctionBtns[btn]->fn);
-        _locoFunctionBtns[btn]->draw(_loco->functions & funcmask);
-
-        x += width + 6 + extra;
-        btn++;
-        col++;
+  const uint8_t *packed = _profile->functions();
+  LocoProfile::Function fn;
+  for (uint8_t row = 0; row < rows; row++) {
+    uint8_t cols = _profile->getColumns(row);
+    if (_paging != nullptr && divideAndCeil(row + 1, 6) != _paging->getPage()) { // Skip rows on other pages
+      for (uint8_t col = 0; col < cols; col++) {
+        packed = _profile->next(packed, fn);
+      }
+      continue;
+    }
+
+    uint8_t width = (240 - ((cols - 1) * 6)) / cols;
+    uint8_t x = 0;
+    for (uint8_t col = 0; col < cols; col++) {
+      packed = _profile->next(packed, fn);
+      // Needed for 4 button rows as it divides to a half pixel so the two inner buttons are 1 pixel wider
+      uint8_t extra = cols == 4 && (col == 1 || col == 2) ? 1 : 0;
+      _locoFunctionBtns[btn] = new FunctionButton(_tft, _imageReader, x, y, width + extra, 32, fn.label, {
+        ILI9341_WHITE,
+        fn.idleFill,
+        fn.idleText,
+        fn.idleIcon
+      }, {
+        ILI9341_WHITE,
+        fn.pressedFill,
+        fn.pressedText,
+        fn.pressedIcon
+      }, fn.fn, fn.latching);
+
+      bool on = _loco->functions.test(fn.fn);
+      if (all || _shownFunctions.test(fn.fn) != on) {
+        _locoFunctionBtns[btn]->draw(on);
       }
-      y += 38;
+
+      x += width + 6 + extra;
+      btn++;
     }
+    y += 38;
   }
+
+  _shownFunctions = _loco->functions;
 }
 
 int8_t Loco::touch(uint16_t x, uint16_t y, Touched touched) {
   for (uint8_t i = 0; i < _locoFunctionCount; i++) {
     if (_locoFunctionBtns[i]->contains(x, y)) {
-      uint32_t funcmask = (1UL << _locoFunctionBtns[i]->fn);
-      _locoFunctionBtns[i]->draw(!(_loco->functions & funcmask));
+      uint8_t fn = _locoFunctionBtns[i]->fn;
+      _locoFunctionBtns[i]->draw(!_loco->functions.test(fn));
       if (_locoFunctionBtns[i]->latching) { // Toggle state for latching functions
-        if (_loco->functions & funcmask) {
-          _loco->functions &= ~funcmask;
-        } else {
-          _loco->functions |= funcmask;
-        }
-        _dcc->setFn(_loco->address, _locoFunctionBtns[i]->fn, _loco->functions & funcmask);
+        bool on = _loco->functions.toggle(fn);
+        _shownFunctions = _loco->functions;
+        _dcc->setFn(_loco->address, fn, on);
       } else { // Set non latching function to on
         _dcc->setFn(_loco->address, _locoFunctionBtns[i]->fn, true);
         delay(250);
@@ -183,8 +169,10 @@ int8_t Loco::touch(uint16_t x, uint16_t y, Touched touched) {
     }
   }
   if (_paging != nullptr && _paging->touch(x, y, touched)) {
+    uint32_t start = millis();
     destroyFunctionButtons();
     drawFunctionButtons();
+    _pageTurn = millis() - start;
   }
 
   return -1;
@@ -193,7 +181,7 @@ int8_t Loco::touch(uint16_t x, uint16_t y, Touched touched) {
 void Loco::encoderChange(Rotation rotation) {
   // TODO, steps??
   if (rotation == CW) {
-    if (_loco->speed < 127) {
+    if (_loco->speed < 126) { // Top speed of the 128 step speed byte, see `DCCEx::decodeSpeed()`
       _loco->speed++;
     }
   } else {
@@ -202,7 +190,7 @@ void Loco::encoderChange(Rotation rotation) {
     }
   }
 
-  _dcc->setThrottle(_loco->address, _loco->speed, _loco->direction);
+  _dcc->queueThrottle(_loco->address, _loco->speed, _loco->direction);
   printSpeed();
 }
 
@@ -211,7 +199,92 @@ void Loco::encoderPress(bool emergency) {
     printSpeed();
   } else {
     _loco->direction = !_loco->direction;
-    _dcc->setThrottle(_loco->address, _loco->speed, _loco->direction);
+    _dcc->queueThrottle(_loco->address, _loco->speed, _loco->direction);
     printDirection();
   }
 }
+
+void Loco::refresh() {
+  if (_shownSpeed != _loco->speed) {
+    printSpeed();
+  }
+  if (_shownDirection != _loco->direction) {
+    printDirection();
+  }
+  if (_shownFunctions != _loco->functions) {
+    for (uint8_t i = 0; i < _locoFunctionCount; i++) {
+      uint8_t fn = _locoFunctionBtns[i]->fn;
+      if (_shownFunctions.test(fn) != _loco->functions.test(fn)) {
+        _locoFunctionBtns[i]->draw(_loco->functions.test(fn));
+      }
+    }
+    _shownFunctions = _loco->functions;
+  }
+}
+
+void Loco::idle() {
+  if (_paging == nullptr) {
+    return;
+  }
+
+  uint16_t page = _paging->getPage();
+  if (_prefetched != page) {
+    loadIcons(_paging->nextPageNumber());
+    _prefetched = page;
+  }
+}
+
+void Loco::loadIcons(uint16_t page) {
+  uint8_t rows = _profile->getRows();
+  const uint8_t *packed = _profile->functions();
+  LocoProfile::Function fn;
+  for (uint8_t row = 0; row < rows; row++) {
+    uint8_t cols = _profile->getColumns(row);
+    for (uint8_t col = 0; col < cols; col++) {
+      packed = _profile->next(packed, fn);
+      if (divideAndCeil(row + 1, 6) != page) {
+        continue;
+      }
+      // Pressed icons are only drawn on a touch, the cache doesn't have room for them too
+      if (fn.idleIcon != nullptr && !TouchButton::loadIcon(_imageReader, fn.idleIcon)) {
+        return; // The rest would replace icons on screen
+      }
+    }
+  }
+}
+
+void Loco::show(LocoState *loco, LocoProfile *profile) {
+  bool sameLayout = profile != nullptr && _profile != nullptr && profile->sameLayout(_profile);
+  _loco = loco;
+  _profile = profile;
+  _prefetched = 0; // The icons may differ
+
+  _tft->fillRect(0, 0, 207, 22, ILI9341_BLACK);
+  _tft->fillRect(0, 22, 240, 16, ILI9341_BLACK);
+  printName();
+
+  if (_shownSpeed != _loco->speed) {
+    printSpeed();
+  }
+  if (_shownDirection != _loco->direction) {
+    printDirection();
+  }
+
+  // The buttons point into the old profile so are always recreated, with the same layout only changed states are drawn
+  destroyFunctionButtons();
+  if (!sameLayout) {
+    if (_paging != nullptr) {
+      delete _paging;
+      _paging = nullptr;
+      _tft->fillRect(0, 288, 240, 32, ILI9341_BLACK); // Clear paging
+    }
+    createPaging();
+  }
+  drawFunctionButtons(!sameLayout);
+}
+
+Resume Loco::getResume() {
+  Resume resume;
+  resume.page = _paging != nullptr ? _paging->getPage() : 1;
+  return resume;
+}
@@ -6,10 +6,11 @@
 #include <Adafruit_SPITFT.h>
 #include <Adafruit_ImageReader.h>
 #include <SdFat.h>
-#include <ArduinoJson.h>
 #include <Paging.h>
 #include <TouchButton.h>
 #include <DCCEx.h>
+#include <FunctionSet.h>
+#include <LocoProfile.h>
 
 /**
  * @brief Loco directions
@@ -29,7 +30,7 @@ struct LocoState {
   LocoState()
       : speed(0), direction(Direction::FORWARD) { }
   uint16_t address = 0; // Loco DCC address
-  uint32_t functions = 0; // Latching function states, uses bit shift
+  FunctionSet functions; // Latching function states
   uint8_t speed : 7;
   uint8_t direction : 1;
 };
@@ -57,8 +58,10 @@ class Loco : public UI {
      * @param sd 
      * @param dcc 
      * @param loco 
+     * @param profile Name and function layout, must outlive the UI or the next `show()`
+     * @param resume Function page to open at
      */
-    Loco(Adafruit_SPITFT *tft, SdFat *sd, DCCEx *dcc, LocoState *loco);
+    Loco(Adafruit_SPITFT *tft, SdFat *sd, DCCEx *dcc, LocoState *loco, LocoProfile *profile, Resume resume = Resume());
     /**
      * @brief Destroy the `Loco` UI object
      */
@@ -84,11 +87,28 @@ class Loco : public UI {
      * @param emergency 
      */
     void encoderPress(bool emergency);
-  private:
     /**
-     * @brief Pointer to `SdFat` object
+     * @brief Redraw the speed, direction and function buttons that differ from `LocoState`
+     */
+    void refresh();
+    /**
+     * @brief Look up the idle icons of the next function page ahead, as many as fit beside the icons on screen
+     */
+    void idle();
+    /**
+     * @brief Switch to another loco in place, only the regions that differ are redrawn
+     * 
+     * @param loco 
+     * @param profile 
      */
-    SdFat *_sd;
+    void show(LocoState *loco, LocoProfile *profile);
+    /**
+     * @brief Current function page
+     * 
+     * @return Resume 
+     */
+    Resume getResume();
+  private:
     /**
      * @brief Pointer to `DCCEx` object
      */
@@ -98,13 +118,9 @@ class Loco : public UI {
      */
     LocoState *_loco;
     /**
-     * @brief Loco config JSON document
+     * @brief Pointer to `LocoProfile` object, the loco name and function layout
      */
-    StaticJsonDocument<4096> _locoDoc;
-    /**
-     * @brief Array of loco function objects
-     */
-    JsonArray _locoFunctions;
+    LocoProfile *_profile;
     /**
      * @brief Pointer to `Adafruit_ImageReader` object, used for button icons
      */
@@ -112,7 +128,7 @@ class Loco : public UI {
     /**
      * @brief Dynamic array of loco function buttons, will only contain those currently in use
      */
-    FunctionButton **_locoFunctionBtns;
+    FunctionButton **_locoFunctionBtns = nullptr;
     /**
      * @brief How many loco functions are currently in use
      */
@@ -121,6 +137,26 @@ class Loco : public UI {
      * @brief Pointer to `Paging` object, only used if needed
      */
     Paging *_paging = nullptr;
+    /**
+     * @brief Speed shown on screen
+     */
+    uint8_t _shownSpeed;
+    /**
+     * @brief Direction shown on screen
+     */
+    uint8_t _shownDirection;
+    /**
+     * @brief Function states shown on screen
+     */
+    FunctionSet _shownFunctions;
+    /**
+     * @brief Page whose next page's icons have been looked up, 0 if none
+     */
+    uint16_t _prefetched = 0;
+    /**
+     * @brief Print the loco name and address
+     */
+    void printName();
     /**
      * @brief Print current loco speed
      */
@@ -130,13 +166,27 @@ class Loco : public UI {
      */
     void printDirection();
     /**
-     * @brief Draw loco function buttons
+     * @brief Create paging if the function buttons need more than one page
+     * 
+     * @param page Page to start on
+     */
+    void createPaging(uint16_t page = 1);
+    /**
+     * @brief Create and draw loco function buttons for the current page
+     * 
+     * @param all Draw every button on a cleared area, otherwise only those that differ from `_shownFunctions`
      */
-    void drawFunctionButtons();
+    void drawFunctionButtons(bool all = true);
     /**
      * @brief Destroy loco function buttons
      */
     void destroyFunctionButtons();
+    /**
+     * @brief Look up the idle icons of a function page, stopping when the icon cache is full of icons on screen
+     * 
+     * @param page 
+     */
+    void loadIcons(uint16_t page);
 };
 
 #endif
@@ -1,38 +1,27 @@
 #include <LocoByName.h>
 #include <Functions.h>
-#include <ArduinoJson.h>
 
-LocoByName::LocoByName(Adafruit_SPITFT *tft, SdFat *sd, bool groups, Selected selected)
-    : UI(tft), _sd(sd), _selected(selected) {
-  _tft->setCursor(0, 18);
-  _tft->print(F("Select Loco"));
-
-  if (groups) { // Load by groups
-    FatFile json = _sd->open("groups.json");
-    deserializeJson(_doc, json);
-    json.close();
-
-    _btnsDoc = _doc.as<JsonObject>();
-  } else { // Enum locos directory
-    _btnsDoc = _doc.to<JsonObject>();
-    FatFile locoDir = _sd->open("/locos");
-    FatFile loco;
-
-    while (loco.openNext(&locoDir, O_READ)) {
-      if (!loco.isSubDir() && !loco.isHidden()) {
-        addLoco(loco);
-      }
-      loco.close();
+LocoByName::LocoByName(Adafruit_SPITFT *tft, SdFat *sd, bool groups, Resume resume, Selected selected, Search search)
+    : UI(tft), _roster(sd), _groupIndex(sd, &_roster), _groups(groups), _selected(selected), _search(search) {
+  if (groups) { // Groups from the groups index, only rebuilt if `groups.json` or `/locos` has changed
+    _valid = _groupIndex.update();
+    if (resume.group < _groupIndex.count()) { // Reopen the group that was open
+      _group = resume.group;
+    }
+  } else { // Locos from the roster index, only rebuilt if `/locos` has changed
+    _roster.update();
+    if (_search != nullptr) {
+      _searchBtn = new TouchButton(_tft, 132, 0, 74, 26, F("Search"));
     }
-    locoDir.close();
-    // _sd->cacheClear();
   }
 
-  drawPagingAndButtons();
+  printTitle();
+  drawPagingAndButtons(resume.page);
 }
 
 LocoByName::~LocoByName() {
   delete _paging;
+  delete _searchBtn;
 
   destroyButtons();
 }
@@ -44,28 +33,30 @@ void LocoByName::destroyButtons() {
   delete[] _btns;
 }
 
-void LocoByName::addLoco(FatFile loco) {
-  StaticJsonDocument<16> filterDoc;
-  filterDoc[F("name")] = true;
-  StaticJsonDocument<64> locoDoc;
-
-  deserializeJson(locoDoc, loco, DeserializationOption::Filter(filterDoc));
-  char *name = locoDoc[F("name")];
-  _btnsDoc[name] = getAddrFromFN(loco);
-}
-
-uint16_t LocoByName::getAddrFromFN(FatFile &loco) {
-  char buf[14] = { 0 };
-  loco.getName(buf, sizeof(buf));
-  return (uint16_t)strtoul(buf, (char **)NULL, 10);
+void LocoByName::printTitle() {
+  _tft->fillRect(0, 0, _searchBtn != nullptr ? 130 : 207, 22, ILI9341_BLACK);
+  _tft->setCursor(0, 18);
+  if (!_valid) { // Missing or not an object of arrays of addresses
+    _tft->setTextColor(ILI9341_RED);
+    _tft->print(F("Invalid groups.json"));
+    _tft->setTextColor(ILI9341_WHITE);
+  } else {
+    _tft->print(F("Select Loco"));
+  }
 }
 
-void LocoByName::drawPagingAndButtons() {
-  _count = _btnsDoc.size();
+void LocoByName::drawPagingAndButtons(uint16_t page) {
+  if (!_groups) {
+    _count = _roster.count();
+  } else if (_group == Resume::NO_GROUP) {
+    _count = _groupIndex.count();
+  } else {
+    _count = _groupIndex.open(_group);
+  }
 
   if (_count > 8) { // If there's more than 8 buttons we need paging
-    uint8_t pages = divideAndCeil(_count, 7);
-    _paging = new Paging(_tft, pages);
+    uint16_t pages = divideAndCeil(_count, 7);
+    _paging = new Paging(_tft, pages, page);
   } else {
     _paging = nullptr;
   }
@@ -73,63 +64,105 @@ void LocoByName::drawPagingAndButtons() {
   drawButtons();
 }
 
-void LocoByName::loadGroup(JsonArray locos) {
-  _btnsDoc.clear();
-  for (uint16_t address : locos) {
-    char buf[32];
-    sprintf_P(buf, PSTR("/locos/%d.json"), address);
-    FatFile loco = _sd->open(buf, O_READ);
-    addLoco(loco);
-    loco.close();
-  }
+void LocoByName::loadGroup(uint8_t group) {
+  _group = group;
+  _shownPage = 0;
+  memset(_prefetch, 0, sizeof(_prefetch)); // Pages of the group list
 
   delete _paging;
   _tft->fillRect(0, 288, 240, 32, ILI9341_BLACK); // Clear paging
   destroyButtons();
+  printTitle();
   drawPagingAndButtons();
 }
 
 void LocoByName::drawButtons() {
   _tft->fillRect(0, 30, 240, 254, ILI9341_BLACK); // Clear buttons
 
-  if (_paging != nullptr) {
-    _btnCount = min(_count - ((_paging->getPage() - 1) * 7), 7);
+  uint16_t page = _paging != nullptr ? _paging->getPage() : 0;
+  Prefetch *prefetched = nullptr;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (page != 0 && _prefetch[i].page == page) {
+      prefetched = &_prefetch[i];
+    }
+  }
+
+  if (prefetched != nullptr) { // Read ahead, only drawn
+    // Keep the page being left in the other buffer, it's next to the new page
+    Prefetch *left = prefetched == &_prefetch[0] ? &_prefetch[1] : &_prefetch[0];
+    left->page = _shownPage;
+    left->count = min(_btnCount, 7);
+    memcpy(left->entries, _entries, left->count * recordSize());
+
+    _btnCount = prefetched->count;
+    memcpy(_entries, prefetched->entries, _btnCount * recordSize());
+    prefetched->page = 0;
+  } else if (_paging != nullptr) { // Only the page is read from the index
+    _btnCount = readRecords((page - 1) * 7, pageCount(page), _entries, _groupEntries);
   } else {
-    _btnCount = min(_count, 8);
+    _btnCount = readRecords(0, min(_count, 8), _entries, _groupEntries);
   }
+  _shownPage = page;
 
-  _btns = new ValueButton*[_btnCount];
+  _btns = new TouchButton*[_btnCount];
 
-  uint8_t btn = 0;
   uint16_t y = 30;
-  uint8_t i = 0;
-  
-  for (JsonPair pair : _btnsDoc) {
-    if (_paging == nullptr || divideAndCeil(++i, 7) == _paging->getPage()) {
-      _btns[btn++] = new ValueButton(_tft, 0, y, 240, 31, pair.key().c_str(), pair.value());
-      y += 37;
-    }
+  for (uint8_t btn = 0; btn < _btnCount; btn++) {
+    const char *name = _groups && _group == Resume::NO_GROUP ? _groupEntries[btn].name : _entries[btn].name;
+    _btns[btn] = new TouchButton(_tft, 0, y, 240, 31, name);
+    y += 37;
   }
 }
 
+void LocoByName::turnPage() {
+  uint32_t start = millis();
+  destroyButtons();
+  drawButtons();
+  _pageTurn = millis() - start;
+}
+
+uint8_t LocoByName::pageCount(uint16_t page) {
+  return min(_count - ((page - 1) * 7), 7);
+}
+
+size_t LocoByName::recordSize() {
+  return _groups && _group == Resume::NO_GROUP ? sizeof(GroupIndex::Group) : sizeof(RosterIndex::Entry);
+}
+
+uint8_t LocoByName::readRecords(uint16_t first, uint8_t n, RosterIndex::Entry *entries, GroupIndex::Group *groups) {
+  if (!_groups) {
+    return _roster.read(first, entries, n);
+  } else if (_group == Resume::NO_GROUP) {
+    return _groupIndex.readGroups(first, groups, n);
+  }
+  return _groupIndex.readLocos(first, entries, n);
+}
+
 int8_t LocoByName::touch(uint16_t x, uint16_t y, Touched touched) {
+  if (_searchBtn != nullptr && _searchBtn->contains(x, y)) {
+    _searchBtn->draw(true);
+    while (touched()) {
+      delay(50);
+    }
+    _search();
+    return -1;
+  }
   for (uint8_t i = 0; i < _btnCount; i++) {
     if (_btns[i]->contains(x, y)) {
       _btns[i]->draw(true);
       while (touched()) {
         delay(50);
       }
-      if (_btns[i]->value.is<JsonArray>()) { // Button is a group
-        loadGroup(_btns[i]->value.as<JsonArray>());
+      if (_groups && _group == Resume::NO_GROUP) { // Button is a group
+        loadGroup((_paging != nullptr ? (_paging->getPage() - 1) * 7 : 0) + i);
       } else { // Button is a loco
-        _selected(_btns[i]->value.as<uint16_t>());
+        _selected(_entries[i].address);
       }
       return -1;
     }
   }
   if (_paging != nullptr && _paging->touch(x, y, touched)) {
-    destroyButtons();
-    drawButtons();
+    turnPage();
   }
 
   return -1;
@@ -138,7 +171,31 @@ int8_t LocoByName::touch(uint16_t x, uint16_t y, Touched touched) {
 void LocoByName::encoderChange(Rotation rotation) {
   if (_paging != nullptr) {
     _paging->encoderChange(rotation);
-    destroyButtons();
-    drawButtons();
+    turnPage();
   }
 }
+
+void LocoByName::idle() {
+  if (_paging == nullptr) {
+    return;
+  }
+
+  uint16_t wanted[2] = { _paging->nextPageNumber(), _paging->prevPageNumber() };
+  for (uint8_t i = 0; i < 2; i++) {
+    if (wanted[i] == _shownPage || _prefetch[0].page == wanted[i] || _prefetch[1].page == wanted[i]) {
+      continue;
+    }
+    // Replace the buffer that isn't holding the other wanted page
+    Prefetch *prefetch = _prefetch[0].page == wanted[1 - i] ? &_prefetch[1] : &_prefetch[0];
+    prefetch->count = readRecords((wanted[i] - 1) * 7, pageCount(wanted[i]), prefetch->entries, prefetch->groups);
+    prefetch->page = wanted[i];
+    return; // A page each loop, so input isn't held up
+  }
+}
+
+Resume LocoByName::getResume() {
+  Resume resume;
+  resume.page = _paging != nullptr ? _paging->getPage() : 1;
+  resume.group = _group;
+  return resume;
+}
@@ -3,36 +3,31 @@
 
 #include <UI.h>
 #include <SdFat.h>
-#include <ArduinoJson.h>
+#include <RosterIndex.h>
+#include <GroupIndex.h>
 #include <Paging.h>
 
-/**
- * @brief Extended `TouchButton` that has `JsonVariant` property
- */
-class ValueButton : public TouchButton {
-  public:
-    JsonVariant value;
-    ValueButton(Adafruit_SPITFT *tft,
-                int16_t x, int16_t y, uint16_t w, uint16_t h,
-                const char *label, JsonVariant value)
-        : TouchButton(tft, x, y, w, h, label), value(value) { }
-};
-
 class LocoByName : public UI {
   public:
     /**
      * @brief Lambda declaration
      */
     using Selected = void(*)(uint16_t);
+    /**
+     * @brief Lambda declaration
+     */
+    using Search = void(*)();
     /**
      * @brief Construct a new `LocoByName` object
      * 
      * @param tft 
      * @param sd 
      * @param groups 
+     * @param resume Page and group to open at
      * @param selected 
+     * @param search Search button touched, the button is only shown when not listing groups
      */
-    LocoByName(Adafruit_SPITFT *tft, SdFat *sd, bool groups, Selected selected);
+    LocoByName(Adafruit_SPITFT *tft, SdFat *sd, bool groups, Resume resume, Selected selected, Search search = nullptr);
     /**
      * @brief Destroy the `LocoByName` object
      */
@@ -52,23 +47,63 @@ class LocoByName : public UI {
      * @param rotation 
      */
     void encoderChange(Rotation rotation);
+    /**
+     * @brief Read the next and previous pages ahead, a page at a time
+     */
+    void idle();
+    /**
+     * @brief Current page and open group
+     * 
+     * @return Resume 
+     */
+    Resume getResume();
   private:
     /**
-     * @brief Pointer to `SdFat` object
+     * @brief Records of a page read ahead, so turning to it only draws
+     */
+    struct Prefetch {
+      uint16_t page; // 0 if empty
+      uint8_t count;
+      union {
+        RosterIndex::Entry entries[7];
+        GroupIndex::Group groups[7];
+      };
+    };
+    /**
+     * @brief Index of every loco sorted by name, used when not listing groups
+     */
+    RosterIndex _roster;
+    /**
+     * @brief Index of `groups.json`, used when listing groups
+     */
+    GroupIndex _groupIndex;
+    /**
+     * @brief Records on the current page, locos or groups if no group is open
+     */
+    union {
+      RosterIndex::Entry _entries[8];
+      GroupIndex::Group _groupEntries[8];
+    };
+    /**
+     * @brief Page of the records in `_entries`, 0 if not paging
+     */
+    uint16_t _shownPage = 0;
+    /**
+     * @brief Pages either side of the current page
      */
-    SdFat *_sd;
+    Prefetch _prefetch[2] = { };
     /**
-     * @brief JSON document to store button info
+     * @brief Did `groups.json` parse
      */
-    StaticJsonDocument<4096> _doc;
+    bool _valid = true;
     /**
-     * @brief Button JSON document
+     * @brief Listing groups rather than the roster
      */
-    JsonObject _btnsDoc;
+    bool _groups;
     /**
      * @brief Count of all the possible buttons
      */
-    uint8_t _count = 0;
+    uint16_t _count = 0;
     /**
      * @brief Count of buttons currently used
      */
@@ -76,7 +111,7 @@ class LocoByName : public UI {
     /**
      * @brief Dynamic array of buttons
      */
-    ValueButton **_btns;
+    TouchButton **_btns;
     /**
      * @brief Pointer to `Paging` object, only used if needed
      */
@@ -85,37 +120,69 @@ class LocoByName : public UI {
      * @brief Loco selected
      */
     Selected _selected;
+    /**
+     * @brief Search button touched
+     */
+    Search _search;
+    /**
+     * @brief Opens `LocoSearch`, only used when not listing groups
+     */
+    TouchButton *_searchBtn = nullptr;
+    /**
+     * @brief Index of the open group, `Resume::NO_GROUP` if none
+     */
+    uint8_t _group = Resume::NO_GROUP;
     /**
      * @brief Destroy the loco buttons
      */
     void destroyButtons();
     /**
-     * @brief Add loco to the button JSON document
+     * @brief Draw paging and buttons
      * 
-     * @param loco 
+     * @param page Page to start on
      */
-    void addLoco(FatFile loco);
+    void drawPagingAndButtons(uint16_t page = 1);
     /**
-     * @brief Get the loco address from the file name
+     * @brief Open a group and redraw with its locos
      * 
-     * @param loco 
-     * @return uint16_t 
+     * @param group 
      */
-    uint16_t getAddrFromFN(FatFile &loco);
+    void loadGroup(uint8_t group);
     /**
-     * @brief Draw paging and buttons
+     * @brief Draw loco buttons
+     */
+    void drawButtons();
+    /**
+     * @brief Redraw the buttons for the new page
      */
-    void drawPagingAndButtons();
+    void turnPage();
     /**
-     * @brief Load a loco group
+     * @brief Records on a page, 7 to a page
      * 
-     * @param locos 
+     * @param page 
+     * @return uint8_t 
      */
-    void loadGroup(JsonArray locos);
+    uint8_t pageCount(uint16_t page);
     /**
-     * @brief Draw loco buttons
+     * @brief Read consecutive records from the roster or groups index
+     * 
+     * @param first 
+     * @param n 
+     * @param entries Where locos are read to
+     * @param groups Where groups are read to, the same records as `entries`
+     * @return uint8_t Records read
      */
-    void drawButtons();
+    uint8_t readRecords(uint16_t first, uint8_t n, RosterIndex::Entry *entries, GroupIndex::Group *groups);
+    /**
+     * @brief Size of the records being listed, groups are bigger than locos
+     * 
+     * @return size_t 
+     */
+    size_t recordSize();
+    /**
+     * @brief Print the title, or an error if `groups.json` didn't parse
+     */
+    void printTitle();
 };
 
 #endif
@@ -0,0 +1,292 @@
+#include <LocoProfile.h>
+#include <Adafruit_ILI9341.h>
+#include <Functions.h>
+#include <FunctionMapCache.h>
+
+uint16_t LocoProfile::_compiles = 0;
+
+LocoProfile::LocoProfile(uint16_t address)
+    : _address(address) { }
+
+LocoProfile::~LocoProfile() {
+  delete[] _data;
+}
+
+LocoProfile *LocoProfile::load(SdFat *sd, uint16_t address) {
+  char path[16];
+  binaryPath(path, address);
+
+  File file;
+  if (SdCache::open(file, path)) {
+    Header header;
+    bool valid = file.read(&header, sizeof(header)) == sizeof(header) &&
+        memcmp_P(header.magic, PSTR("LCB"), sizeof(header.magic)) == 0 && header.version == VERSION &&
+        header.layoutSize < header.size && header.size <= MAX_SIZE;
+    header.functions[FUNCTIONS_SIZE - 1] = '\0';
+    if (valid && header.signature == signature(sd, address, header.functions)) { // JSON unchanged since it was compiled
+      LocoProfile *profile = new LocoProfile(address);
+      if (profile == nullptr) {
+        file.close();
+        return nullptr;
+      }
+      profile->_size = header.size;
+      profile->_layoutSize = header.layoutSize;
+      profile->_data = new uint8_t[header.size];
+      if (profile->_data != nullptr && file.read(profile->_data, header.size) == (int)header.size) {
+        file.close();
+        return profile;
+      }
+      delete profile;
+    }
+    file.close();
+  }
+
+  return compile(sd, address);
+}
+
+uint16_t LocoProfile::getCompiles() {
+  return _compiles;
+}
+
+LocoProfile *LocoProfile::compile(SdFat *sd, uint16_t address) {
+  _compiles++;
+  ArenaDocument doc;
+  char path[32];
+  sprintf_P(path, PSTR("/locos/%d.json"), address);
+
+  File json;
+  if (SdCache::open(json, path)) { // Check for loco config file, opened once rather than checked then opened
+    doc.read(json);
+    json.close();
+  }
+
+  // Keep the names, a function map file replaces the document
+  char name[NAME_SIZE];
+  strlcpy(name, doc[F("name")] | "", sizeof(name));
+  char map[FUNCTIONS_SIZE];
+  bool fits = strlcpy(map, doc[F("functions")] | "", sizeof(map)) < sizeof(map);
+
+  JsonArrayConst rows = doc[F("functions")].as<JsonArrayConst>(); // Function map array in loco config json
+  const uint8_t *layout = nullptr; // Cached function map layout
+  uint16_t layoutSize = 0;
+  uint32_t mapStamp = 0;
+  if (doc[F("functions")].is<const char*>()) { // Name of function map file
+    snprintf_P(path, sizeof(path), PSTR("/fns/%s.json"), doc[F("functions")].as<const char*>());
+    mapStamp = fileStamp(FNV_BASIS, path);
+    if (fits) { // Only whole map names are keys
+      layout = FunctionMapCache::find(map, mapStamp, layoutSize);
+    }
+    if (layout == nullptr) {
+      SdCache::open(json, path); // A missing map is read as empty, shown as the error
+      doc.read(json);
+      json.close();
+      rows = doc.as<JsonArrayConst>();
+    }
+  }
+
+  bool error = doc.getError();
+  if (error) { // Show the error as the name rather than a partly loaded loco
+    snprintf_P(name, sizeof(name), PSTR("JSON %s"), doc.getError().c_str());
+  }
+
+  if (layout == nullptr && rows.size() == 0) { // Create 29 default functions if none were specified
+    JsonArray functions = doc.to<JsonArray>();
+    char buf[4];
+    JsonArray row;
+    for (uint8_t i = 0; i < 29; i++) {
+      if (i % 3 == 0) { // New row
+        row = functions.createNestedArray();
+      }
+      JsonObject fn = row.createNestedObject();
+      sprintf_P(buf, PSTR("F%d"), i);
+      fn[F("label")] = buf;
+      fn[F("fn")] = i;
+      // TODO, which Fn's are by default non latching?
+    }
+    rows = functions;
+  }
+
+  LocoProfile *profile = new LocoProfile(address);
+  if (profile == nullptr) {
+    return nullptr;
+  }
+  if (layout == nullptr) {
+    layoutSize = pack(rows, nullptr);
+  }
+  profile->_layoutSize = layoutSize;
+  profile->_size = layoutSize + strlen(name) + 1;
+  profile->_data = new uint8_t[profile->_size];
+  if (profile->_data == nullptr) { // Out of memory while the arena is borrowed
+    delete profile;
+    return nullptr;
+  }
+  if (layout != nullptr) {
+    memcpy(profile->_data, layout, layoutSize);
+  } else {
+    pack(rows, profile->_data);
+    if (map[0] != '\0' && !error && fits) {
+      FunctionMapCache::add(map, mapStamp, profile->_data, layoutSize);
+    }
+  }
+  strcpy((char *)profile->_data + layoutSize, name);
+
+  // A longer map name can't be checked for changes so it's compiled every time
+  if (!error && fits && profile->_size <= MAX_SIZE) {
+    profile->save(sd, map);
+  }
+  return profile;
+}
+
+void LocoProfile::save(SdFat *sd, const char *functions) {
+  sd->mkdir("/cfg");
+  char path[16];
+  binaryPath(path, _address);
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy_P(header.magic, PSTR("LCB"), sizeof(header.magic));
+  header.version = VERSION;
+  header.size = _size;
+  header.layoutSize = _layoutSize;
+  header.signature = signature(sd, _address, functions);
+  strlcpy(header.functions, functions, sizeof(header.functions));
+
+  File file = sd->open(path, O_RDWR | O_CREAT | O_TRUNC);
+  file.write(&header, sizeof(header));
+  file.write(_data, _size);
+  file.close();
+}
+
+uint32_t LocoProfile::signature(SdFat *sd, uint16_t address, const char *functions) {
+  char path[32];
+  sprintf_P(path, PSTR("/locos/%d.json"), address);
+  uint32_t hash = fileStamp(FNV_BASIS, path);
+  if (functions[0] != '\0') {
+    snprintf_P(path, sizeof(path), PSTR("/fns/%s.json"), functions);
+    hash = fileStamp(hash, path);
+  }
+  return hash;
+}
+
+void LocoProfile::binaryPath(char *path, uint16_t address) {
+  sprintf_P(path, PSTR("/cfg/%u.bin"), address);
+}
+
+uint16_t LocoProfile::pack(JsonArrayConst rows, uint8_t *data) {
+  uint16_t size = 0;
+  auto put = [&](uint8_t value) {
+    if (data != nullptr) {
+      data[size] = value;
+    }
+    size++;
+  };
+  auto putString = [&](const char *value) {
+    do {
+      put(*value);
+    } while (*value++ != '\0');
+  };
+
+  put(rows.size());
+  for (JsonArrayConst const& row : rows) {
+    put(row.size());
+  }
+
+  for (JsonArrayConst const& row : rows) {
+    for (JsonObjectConst const& fn : row) {
+      JsonObjectConst idle = fn[F("btn")][F("idle")];
+      JsonObjectConst pressed = fn[F("btn")][F("pressed")];
+      JsonVariantConst colours[] = { idle[F("fill")], idle[F("text")], pressed[F("fill")], pressed[F("text")] };
+      const char *strings[] = { fn[F("label")], idle[F("icon")], pressed[F("icon")] };
+
+      // Flags follow the order of `colours` then `strings`
+      uint8_t fields = 0;
+      for (uint8_t i = 0; i < 4; i++) {
+        if (!colours[i].isNull()) {
+          fields |= Field::IDLE_FILL << i;
+        }
+      }
+      for (uint8_t i = 0; i < 3; i++) {
+        if (strings[i] != nullptr) {
+          fields |= Field::LABEL << i;
+        }
+      }
+
+      put((fn[F("fn")] | 0) | ((fn[F("latching")] | true) ? LATCHING : 0));
+      put(fields);
+      for (uint8_t i = 0; i < 4; i++) {
+        if (fields & (Field::IDLE_FILL << i)) {
+          uint16_t colour = colours[i];
+          put(colour);
+          put(colour >> 8);
+        }
+      }
+      for (uint8_t i = 0; i < 3; i++) {
+        if (fields & (Field::LABEL << i)) {
+          putString(strings[i]);
+        }
+      }
+    }
+  }
+
+  return size;
+}
+
+const uint8_t *LocoProfile::next(const uint8_t *packed, Function &function) {
+  function.fn = packed[0] & ~LATCHING;
+  function.latching = packed[0] & LATCHING;
+  uint8_t fields = packed[1];
+  packed += 2;
+
+  uint16_t colours[] = { ILI9341_BLACK, ILI9341_WHITE, ILI9341_WHITE, ILI9341_BLACK };
+  for (uint8_t i = 0; i < 4; i++) {
+    if (fields & (Field::IDLE_FILL << i)) {
+      colours[i] = packed[0] | packed[1] << 8;
+      packed += 2;
+    }
+  }
+  const char *strings[] = { nullptr, nullptr, nullptr };
+  for (uint8_t i = 0; i < 3; i++) {
+    if (fields & (Field::LABEL << i)) {
+      strings[i] = (const char *)packed;
+      packed += strlen(strings[i]) + 1;
+    }
+  }
+
+  function.label = strings[0];
+  function.idleFill = colours[0];
+  function.idleText = colours[1];
+  function.idleIcon = strings[1];
+  function.pressedFill = colours[2];
+  function.pressedText = colours[3];
+  function.pressedIcon = strings[2];
+  return packed;
+}
+
+uint16_t LocoProfile::getAddress() {
+  return _address;
+}
+
+const char *LocoProfile::getName() {
+  const char *name = (const char *)_data + _layoutSize;
+  return *name != '\0' ? name : nullptr;
+}
+
+uint8_t LocoProfile::getRows() {
+  return _data[0];
+}
+
+uint8_t LocoProfile::getColumns(uint8_t row) {
+  return _data[1 + row];
+}
+
+const uint8_t *LocoProfile::functions() {
+  return _data + 1 + getRows();
+}
+
+uint16_t LocoProfile::getSize() {
+  return sizeof(LocoProfile) + _size;
+}
+
+bool LocoProfile::sameLayout(LocoProfile *other) {
+  return _layoutSize == other->_layoutSize && memcmp(_data, other->_data, _layoutSize) == 0;
+}
@@ -0,0 +1,221 @@
+#ifndef LOCO_PROFILE_H
+#define LOCO_PROFILE_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <ArduinoJson.h>
+#include <JsonArena.h>
+
+/**
+ * @brief Loco name and function button layout resolved from its SD config, packed into a single block
+ * The JSON is parsed once on load, the `Loco` UI is then built from the packed layout without touching the SD.
+ * The packed block is saved as a compiled config, `/cfg/<address>.bin`, which later loads read in one go while
+ * the JSON it was compiled from is unchanged. `tools/compile_locos.py` writes the same files on a PC
+ */
+class LocoProfile {
+  public:
+    /**
+     * @brief A function button unpacked from the layout, strings point into the profile
+     */
+    struct Function {
+      uint8_t fn;
+      bool latching;
+      const char *label; // nullptr if there isn't one
+      uint16_t idleFill;
+      uint16_t idleText;
+      const char *idleIcon; // nullptr if there isn't one
+      uint16_t pressedFill;
+      uint16_t pressedText;
+      const char *pressedIcon; // nullptr if there isn't one
+    };
+    /**
+     * @brief Load a loco's profile from its compiled config, compiling it first if it's missing or out of date
+     * 
+     * @param sd 
+     * @param address 
+     * @return LocoProfile* `nullptr` if there isn't the memory for it
+     */
+    static LocoProfile *load(SdFat *sd, uint16_t address);
+    /**
+     * @brief Configs compiled from JSON since startup
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getCompiles();
+    /**
+     * @brief Destroy the `LocoProfile` object
+     */
+    ~LocoProfile();
+    /**
+     * @brief Loco DCC address
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getAddress();
+    /**
+     * @brief Loco name from the config
+     * 
+     * @return const char* nullptr if the config doesn't have one
+     */
+    const char *getName();
+    /**
+     * @brief Rows of function buttons
+     * 
+     * @return uint8_t 
+     */
+    uint8_t getRows();
+    /**
+     * @brief Function buttons in a row
+     * 
+     * @param row 
+     * @return uint8_t 
+     */
+    uint8_t getColumns(uint8_t row);
+    /**
+     * @brief First packed function, pass to `next()` to unpack the functions in order
+     * 
+     * @return const uint8_t* 
+     */
+    const uint8_t *functions();
+    /**
+     * @brief Unpack a function
+     * 
+     * @param packed 
+     * @param function 
+     * @return const uint8_t* The packed function after it
+     */
+    const uint8_t *next(const uint8_t *packed, Function &function);
+    /**
+     * @brief Bytes of heap used by the profile
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getSize();
+    /**
+     * @brief Do both profiles have the same function buttons, e.g. they share a function map
+     * 
+     * @param other 
+     * @return true 
+     * @return false 
+     */
+    bool sameLayout(LocoProfile *other);
+  private:
+    /**
+     * @brief Longest name kept, including the terminator
+     */
+    static const uint8_t NAME_SIZE = 32;
+    /**
+     * @brief Longest function map name a compiled config can hold, including the terminator
+     */
+    static const uint8_t FUNCTIONS_SIZE = 20;
+    /**
+     * @brief Largest packed block, it's packed from a JSON arena of config so it's smaller than the arena, plus the name
+     */
+    static const uint16_t MAX_SIZE = JsonArena::SIZE + NAME_SIZE;
+    /**
+     * @brief Compiled config format version, a different version is recompiled
+     */
+    static const uint8_t VERSION = 1;
+    /**
+     * @brief Compiled config header, followed by the packed block
+     */
+    struct Header {
+      char magic[3];
+      uint8_t version;
+      uint16_t size; // Bytes in the packed block
+      uint16_t layoutSize; // Bytes in the packed block before the name
+      uint32_t signature; // Of the JSON files it was compiled from, see `signature()`
+      char functions[FUNCTIONS_SIZE]; // Function map name, empty if the config has its own functions
+    };
+    /**
+     * @brief Configs compiled from JSON since startup
+     */
+    static uint16_t _compiles;
+    /**
+     * @brief Set on a packed function's first byte if it's latching, the rest is the function #
+     */
+    static const uint8_t LATCHING = 0x80;
+    /**
+     * @brief Packed function flags for the optional fields present after it, in this order
+     */
+    struct FieldEnum {
+      enum Fields : uint8_t {
+        IDLE_FILL = 0x01,
+        IDLE_TEXT = 0x02,
+        PRESSED_FILL = 0x04,
+        PRESSED_TEXT = 0x08,
+        LABEL = 0x10,
+        IDLE_ICON = 0x20,
+        PRESSED_ICON = 0x40
+      };
+    };
+    typedef FieldEnum::Fields Field;
+    /**
+     * @brief Construct a new `LocoProfile` object
+     * 
+     * @param address 
+     */
+    LocoProfile(uint16_t address);
+    /**
+     * @brief Loco DCC address
+     */
+    uint16_t _address;
+    /**
+     * @brief Row count, columns per row, packed functions then the name
+     * A packed function is the function # and latching bit, `Field` flags, present colours then present strings
+     */
+    uint8_t *_data = nullptr;
+    /**
+     * @brief Bytes in `_data`
+     */
+    uint16_t _size = 0;
+    /**
+     * @brief Bytes in `_data` before the name
+     */
+    uint16_t _layoutSize = 0;
+    /**
+     * @brief Parse the JSON config, `/locos/<address>.json` and `/fns/<name>.json` if it names a function map
+     * Locos without a config or functions get 29 default functions, F0 - F28.
+     * A function map's layout is taken from the `FunctionMapCache` while the map file is unchanged.
+     * A config that doesn't parse or fit the `JsonArena` gets the default functions and the error as its name,
+     * it isn't saved so the error shows until it's fixed
+     * 
+     * @param sd 
+     * @param address 
+     * @return LocoProfile* `nullptr` if there isn't the memory for it
+     */
+    static LocoProfile *compile(SdFat *sd, uint16_t address);
+    /**
+     * @brief Save the compiled config
+     * 
+     * @param sd 
+     * @param functions Function map name, empty if none
+     */
+    void save(SdFat *sd, const char *functions);
+    /**
+     * @brief FNV-1a hash of the modified time and size of the loco config and function map, changes when either is edited
+     * 
+     * @param sd 
+     * @param address 
+     * @param functions Function map name, empty if none
+     * @return uint32_t 
+     */
+    static uint32_t signature(SdFat *sd, uint16_t address, const char *functions);
+    /**
+     * @brief Path of a loco's compiled config
+     * 
+     * @param path At least 16 chars
+     * @param address 
+     */
+    static void binaryPath(char *path, uint16_t address);
+    /**
+     * @brief Pack function rows into a layout, or just count the bytes needed
+     * 
+     * @param rows Array of rows of function objects
+     * @param data Where to pack, nullptr to only count
+     * @return uint16_t Bytes packed
+     */
+    static uint16_t pack(JsonArrayConst rows, uint8_t *data);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <LocoSearch.h>
+
+LocoSearch::LocoSearch(Adafruit_SPITFT *tft, SdFat *sd, Selected selected)
+    : KeyPad(tft, F("Search"), 0, 0), _roster(sd), _search(sd, &_roster), _selected(selected) {
+  // Indexes are only rebuilt if `/locos` has changed
+  _search.update();
+
+  // The match replaces the range label
+  _tft->fillRect(0, 72, 240, 32, ILI9341_BLACK);
+  _matchBtn = new TouchButton(_tft, 0, 72, 240, 30, _match.name, false);
+  drawModeButton();
+  changed();
+}
+
+LocoSearch::~LocoSearch() {
+  delete _modeBtn;
+  delete _matchBtn;
+}
+
+int8_t LocoSearch::touch(uint16_t x, uint16_t y, Touched touched) {
+  if (_modeBtn->contains(x, y)) {
+    _modeBtn->draw(true);
+    while (touched()) {
+      delay(50);
+    }
+    _mode = _mode == SearchMode::NAME ? SearchMode::ADDRESS : SearchMode::NAME;
+    _acceptedLength = 0; // Found in the other mode
+    drawModeButton();
+    changed();
+    return -1;
+  }
+
+  if (_matchBtn->contains(x, y) && _count > 0) {
+    _matchBtn->draw(true);
+    while (touched()) {
+      delay(50);
+    }
+    _selected(_match.address);
+    return -1;
+  }
+
+  int8_t btn = KeyPad::touch(x, y, touched);
+  if (btn != -1) {
+    _selected(btn == KeyPadButton::ENTER ? _match.address : 0);
+  }
+
+  return -1;
+}
+
+void LocoSearch::encoderChange(Rotation rotation) {
+  if (rotation == CW && _current + 1 < _count) {
+    _current++;
+    showMatch();
+  } else if (rotation == CCW && _current > 0) {
+    _current--;
+    showMatch();
+  }
+}
+
+bool LocoSearch::accept() {
+  // The digits include the one being typed, it's only kept if there are matches
+  if (getDigits()[0] == '\0') {
+    return _roster.count() > 0;
+  }
+  uint16_t first;
+  uint16_t count = _search.find(_mode, getDigits(), first);
+  if (count == 0) {
+    return false;
+  }
+  _acceptedFirst = first;
+  _acceptedCount = count;
+  _acceptedLength = strlen(getDigits());
+  return true;
+}
+
+void LocoSearch::changed() {
+  uint8_t length = strlen(getDigits());
+  if (length == 0) { // Every loco, in name order
+    _first = 0;
+    _count = _roster.count();
+  } else if (length == _acceptedLength) { // Typed, the matches were found by `accept()`
+    _first = _acceptedFirst;
+    _count = _acceptedCount;
+  } else {
+    _count = _search.find(_mode, getDigits(), _first);
+  }
+  _acceptedLength = 0;
+  _current = 0;
+  showMatch();
+}
+
+void LocoSearch::drawModeButton() {
+  delete _modeBtn;
+  _tft->fillRect(132, 0, 74, 26, ILI9341_BLACK);
+  _modeBtn = new TouchButton(_tft, 132, 0, 74, 26, _mode == SearchMode::NAME ? F("Name") : F("Address"));
+}
+
+void LocoSearch::showMatch() {
+  bool found = false;
+  if (_current < _count) {
+    if (getDigits()[0] == '\0') {
+      found = _roster.read(_first + _current, &_match, 1) == 1;
+    } else {
+      found = _search.read(_mode, _first + _current, _match);
+    }
+  }
+  if (!found) {
+    _count = 0;
+    strcpy_P(_match.name, PSTR("No matches"));
+  }
+  _matchBtn->draw();
+
+  // Title with the match count
+  _tft->fillRect(0, 0, 130, 22, ILI9341_BLACK);
+  _tft->setCursor(0, 18);
+  _tft->print(F("Search"));
+  if (_count > 0) {
+    _tft->print(' ');
+    _tft->print(_current + 1);
+    _tft->print('/');
+    _tft->print(_count);
+  }
+}
@@ -0,0 +1,121 @@
+#ifndef LOCO_SEARCH_H
+#define LOCO_SEARCH_H
+
+#include <KeyPad.h>
+#include <SdFat.h>
+#include <RosterIndex.h>
+#include <RosterSearch.h>
+
+/**
+ * @brief Find a loco by typing the start of its address, or of its name on the keypad letters, 2 = ABC ... 9 = WXYZ
+ * The matching locos are shown one at a time, the encoder steps through them
+ */
+class LocoSearch : public KeyPad {
+  public:
+    /**
+     * @brief Lambda declaration
+     */
+    using Selected = void(*)(uint16_t);
+    /**
+     * @brief Construct a new `LocoSearch` UI object
+     * 
+     * @param tft 
+     * @param sd 
+     * @param selected 
+     */
+    LocoSearch(Adafruit_SPITFT *tft, SdFat *sd, Selected selected);
+    /**
+     * @brief Destroy the `LocoSearch` UI object
+     */
+    ~LocoSearch();
+    /**
+     * @brief Handle UI touch events
+     * 
+     * @param x 
+     * @param y 
+     * @param touched 
+     * @return int8_t 
+     */
+    int8_t touch(uint16_t x, uint16_t y, Touched touched);
+    /**
+     * @brief Handle encoder change event, steps through the matches
+     * 
+     * @param rotation 
+     */
+    void encoderChange(Rotation rotation);
+  protected:
+    /**
+     * @brief Digits can only be typed or entered if they have matches, they're looked up with the new digit
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool accept();
+    /**
+     * @brief Find the matches for the new digits
+     */
+    void changed();
+  private:
+    /**
+     * @brief Index of every loco sorted by name
+     */
+    RosterIndex _roster;
+    /**
+     * @brief Prefix index of `_roster`
+     */
+    RosterSearch _search;
+    /**
+     * @brief What the digits are matched against
+     */
+    SearchMode _mode = SearchMode::NAME;
+    /**
+     * @brief Switches `_mode`
+     */
+    TouchButton *_modeBtn = nullptr;
+    /**
+     * @brief Shows the match, touch to select it
+     */
+    TouchButton *_matchBtn;
+    /**
+     * @brief Match shown, its name is `_matchBtn`'s label
+     */
+    RosterIndex::Entry _match;
+    /**
+     * @brief First match in the search index
+     */
+    uint16_t _first = 0;
+    /**
+     * @brief Matches
+     */
+    uint16_t _count = 0;
+    /**
+     * @brief Match shown, from 0 to `_count` - 1
+     */
+    uint16_t _current = 0;
+    /**
+     * @brief First match of the digits last accepted, so `changed()` doesn't look them up again
+     */
+    uint16_t _acceptedFirst = 0;
+    /**
+     * @brief Matches of the digits last accepted
+     */
+    uint16_t _acceptedCount = 0;
+    /**
+     * @brief Length of the digits last accepted, 0 if `_acceptedFirst` & `_acceptedCount` are stale
+     */
+    uint8_t _acceptedLength = 0;
+    /**
+     * @brief Loco selected
+     */
+    Selected _selected;
+    /**
+     * @brief Replace the mode button with the current mode
+     */
+    void drawModeButton();
+    /**
+     * @brief Read and draw the current match, and the match count in the title
+     */
+    void showMatch();
+};
+
+#endif
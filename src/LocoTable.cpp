@@ -0,0 +1,94 @@
+#include <LocoTable.h>
+
+LocoTable::LocoTable() {
+  memset(_index, EMPTY, sizeof(_index));
+  for (uint8_t i = 0; i < MAX_LOCOS; i++) {
+    _slots[i] = i;
+    _positions[i] = i;
+  }
+}
+
+int8_t LocoTable::get(uint16_t address) {
+  if (address == 0) { // Free slots have address 0
+    return -1;
+  }
+
+  uint8_t i = probe(address);
+  if (_index[i] != EMPTY) {
+    return _index[i];
+  } else if (_count == MAX_LOCOS) {
+    return -1;
+  }
+
+  uint8_t slot = _slots[_count++];
+  _locos[slot].address = address;
+  _index[i] = slot;
+  return slot;
+}
+
+int8_t LocoTable::find(uint16_t address) {
+  if (address == 0) {
+    return -1;
+  }
+
+  uint8_t slot = _index[probe(address)];
+  return slot == EMPTY ? -1 : slot;
+}
+
+void LocoTable::free(uint8_t slot) {
+  uint16_t address = _locos[slot].address;
+  if (address == 0) {
+    return;
+  }
+
+  // Backward shift delete, entries after the hole move back if their home is at or before it
+  uint8_t hole = probe(address);
+  uint8_t i = hole;
+  while (true) {
+    i = (i + 1) & (INDEX_SIZE - 1);
+    if (_index[i] == EMPTY) {
+      break;
+    }
+    uint8_t home = hash(_locos[_index[i]].address);
+    if (((i - home) & (INDEX_SIZE - 1)) >= ((i - hole) & (INDEX_SIZE - 1))) {
+      _index[hole] = _index[i];
+      hole = i;
+    }
+  }
+  _index[hole] = EMPTY;
+
+  // Swap the slot with the last slot in use
+  uint8_t position = _positions[slot];
+  uint8_t last = _slots[--_count];
+  _slots[position] = last;
+  _positions[last] = position;
+  _slots[_count] = slot;
+  _positions[slot] = _count;
+
+  _locos[slot] = LocoState();
+}
+
+uint8_t LocoTable::count() {
+  return _count;
+}
+
+uint8_t LocoTable::active(uint8_t i) {
+  return _slots[i];
+}
+
+LocoState &LocoTable::operator[](uint8_t slot) {
+  return _locos[slot];
+}
+
+uint8_t LocoTable::hash(uint16_t address) {
+  // 40503 is 2^16 / golden ratio, the top 6 bits are the best mixed
+  return (uint16_t)(address * 40503U) >> 10;
+}
+
+uint8_t LocoTable::probe(uint16_t address) {
+  uint8_t i = hash(address);
+  while (_index[i] != EMPTY && _locos[_index[i]].address != address) {
+    i = (i + 1) & (INDEX_SIZE - 1);
+  }
+  return i;
+}
@@ -0,0 +1,106 @@
+#ifndef LOCO_TABLE_H
+#define LOCO_TABLE_H
+
+#include <Arduino.h>
+#include <Loco.h>
+
+/**
+ * @brief `LocoState` slots with an address index and a list of the slots in use
+ * Lookups hash the address into an open addressed index instead of scanning every slot
+ */
+class LocoTable {
+  public:
+    /**
+     * @brief Max locos, same as DCC++Ex
+     */
+    static const uint8_t MAX_LOCOS = 50;
+    /**
+     * @brief Construct a new `LocoTable` object
+     */
+    LocoTable();
+    /**
+     * @brief Get the slot for an address, adding it to a free slot if it isn't in the table
+     * 
+     * @param address 
+     * @return int8_t -1 if the table is full or the address is 0
+     */
+    int8_t get(uint16_t address);
+    /**
+     * @brief Find the slot for an address without adding it
+     * 
+     * @param address 
+     * @return int8_t -1 if the address isn't in the table
+     */
+    int8_t find(uint16_t address);
+    /**
+     * @brief Free a slot and reset its `LocoState`
+     * 
+     * @param slot 
+     */
+    void free(uint8_t slot);
+    /**
+     * @brief Number of slots in use
+     * 
+     * @return uint8_t 
+     */
+    uint8_t count();
+    /**
+     * @brief Slot in use at position `i`, the order changes when a slot is freed
+     * 
+     * @param i 0 to `count()` - 1
+     * @return uint8_t 
+     */
+    uint8_t active(uint8_t i);
+    /**
+     * @brief `LocoState` in a slot
+     * 
+     * @param slot 
+     * @return LocoState&
+     */
+    LocoState &operator[](uint8_t slot);
+  private:
+    /**
+     * @brief Index size, a power of 2 with room to spare so probes stay short
+     */
+    static const uint8_t INDEX_SIZE = 64;
+    /**
+     * @brief Marks an empty index entry
+     */
+    static const uint8_t EMPTY = 0xFF;
+    /**
+     * @brief Loco states
+     */
+    LocoState _locos[MAX_LOCOS];
+    /**
+     * @brief Linear probed address index, each entry is a slot or `EMPTY`
+     */
+    uint8_t _index[INDEX_SIZE];
+    /**
+     * @brief Slots in use followed by the free slots
+     */
+    uint8_t _slots[MAX_LOCOS];
+    /**
+     * @brief Position of each slot in `_slots`
+     */
+    uint8_t _positions[MAX_LOCOS];
+    /**
+     * @brief Slots in use
+     */
+    uint8_t _count = 0;
+    /**
+     * @brief Home index entry for an address, Fibonacci hashed so sequential addresses spread out
+     * 
+     * @param address 
+     * @return uint8_t 
+     */
+    uint8_t hash(uint16_t address);
+    /**
+     * @brief Index entry holding an address, or the empty entry it would go in
+     * 
+     * @param address 
+     * @return uint8_t 
+     */
+    uint8_t probe(uint16_t address);
+};
+
+#endif
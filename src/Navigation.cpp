@@ -0,0 +1,41 @@
+#include <Navigation.h>
+
+void Navigation::push(Screen screen, Resume resume) {
+  remove(screen);
+  _entries[_count].screen = screen;
+  _entries[_count].resume = resume;
+  _count++;
+}
+
+bool Navigation::pop(Entry &entry) {
+  if (_count == 0) {
+    return false;
+  }
+
+  entry = _entries[--_count];
+  return true;
+}
+
+bool Navigation::take(Screen screen, Resume &resume) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_entries[i].screen == screen) {
+      resume = _entries[i].resume;
+      remove(screen);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Navigation::remove(Screen screen) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_entries[i].screen == screen) {
+      // Close the gap, entries stay oldest first
+      for (; i < _count - 1; i++) {
+        _entries[i] = _entries[i + 1];
+      }
+      _count--;
+      return;
+    }
+  }
+}
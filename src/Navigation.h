@@ -0,0 +1,78 @@
+#ifndef NAVIGATION_H
+#define NAVIGATION_H
+
+#include <Arduino.h>
+#include <UI.h>
+
+/**
+ * @brief Screens that can be navigated to
+ */
+struct ScreenEnum {
+  enum Screens : uint8_t {
+    MENU,
+    LOCO,
+    LOCO_BY_ADDRESS,
+    LOCO_BY_NAME,
+    LOCO_BY_GROUP,
+    LOCO_SEARCH,
+    PROGRAM,
+    COUNT // Always at end
+  };
+};
+typedef ScreenEnum::Screens Screen;
+
+/**
+ * @brief Bounded stack of the screens left, with where each was left so going back returns to the same place
+ * A screen is only kept once, navigating away from it again replaces its older entry
+ */
+class Navigation {
+  public:
+    /**
+     * @brief A screen that was left
+     */
+    struct Entry {
+      Screen screen;
+      Resume resume;
+    };
+    /**
+     * @brief Push a screen being left, replacing any older entry for it
+     * 
+     * @param screen 
+     * @param resume 
+     */
+    void push(Screen screen, Resume resume);
+    /**
+     * @brief Pop the last screen left
+     * 
+     * @param entry 
+     * @return true 
+     * @return false The stack is empty
+     */
+    bool pop(Entry &entry);
+    /**
+     * @brief Take a screen's entry out of the stack, wherever it is
+     * 
+     * @param screen 
+     * @param resume Set to where the screen was left, left as it is if the screen isn't in the stack
+     * @return true 
+     * @return false The screen isn't in the stack
+     */
+    bool take(Screen screen, Resume &resume);
+    /**
+     * @brief Remove a screen's entry, e.g. the `Loco` screen when the loco is released
+     * 
+     * @param screen 
+     */
+    void remove(Screen screen);
+  private:
+    /**
+     * @brief Entries, oldest first
+     */
+    Entry _entries[Screen::COUNT];
+    /**
+     * @brief Entries in use
+     */
+    uint8_t _count = 0;
+};
+
+#endif
@@ -1,8 +1,8 @@
 #include <Paging.h>
 #include <Adafruit_ILI9341.h>
 
-Paging::Paging(Adafruit_SPITFT *tft, uint8_t pages)
-    : UI(tft), _pages(pages) {
+Paging::Paging(Adafruit_SPITFT *tft, uint16_t pages, uint16_t page)
+    : UI(tft), _pages(pages), _page(constrain(page, 1, pages)) {
   _prev = new TouchButton(_tft, 0, 288, 76, 32, "<", {
     ILI9341_WHITE,
     ILI9341_DARKGREY,
@@ -53,8 +53,8 @@ void Paging::update() {
   int16_t text_x, text_y;
   uint16_t text_w, text_h;
 
-  char label[6];
-  sprintf_P(label, PSTR("%d\\%d"), _page, _pages);
+  char label[12];
+  sprintf_P(label, PSTR("%u\\%u"), _page, _pages);
 
   _tft->fillRect(82, 288, 76, 32, ILI9341_BLACK);
   _tft->setTextSize(1);
@@ -98,6 +98,14 @@ void Paging::encoderChange(Rotation rotation) {
   }
 }
 
-uint8_t Paging::getPage() {
+uint16_t Paging::getPage() {
   return _page;
 }
+
+uint16_t Paging::nextPageNumber() {
+  return _page < _pages ? _page + 1 : 1;
+}
+
+uint16_t Paging::prevPageNumber() {
+  return _page > 1 ? _page - 1 : _pages;
+}
@@ -19,11 +19,11 @@ class Paging : public UI {
     /**
      * @brief Total pages
      */
-    uint8_t _pages;
+    uint16_t _pages;
     /**
      * @brief Current page
      */
-    uint8_t _page = 1;
+    uint16_t _page = 1;
     /**
      * @brief Change to next page, if greater than total we reset to 1
      */
@@ -42,8 +42,9 @@ class Paging : public UI {
      * 
      * @param tft 
      * @param pages 
+     * @param page Page to start on, kept within `pages`
      */
-    Paging(Adafruit_SPITFT *tft, uint8_t pages);
+    Paging(Adafruit_SPITFT *tft, uint16_t pages, uint16_t page = 1);
     /**
      * @brief Destroy the `Paging` UI object
      */
@@ -66,9 +67,21 @@ class Paging : public UI {
     /**
      * @brief Get the current page #
      * 
-     * @return uint8_t 
+     * @return uint16_t 
      */
-    uint8_t getPage();
+    uint16_t getPage();
+    /**
+     * @brief The page after the current one, wrapping to 1
+     * 
+     * @return uint16_t 
+     */
+    uint16_t nextPageNumber();
+    /**
+     * @brief The page before the current one, wrapping to the last
+     * 
+     * @return uint16_t 
+     */
+    uint16_t prevPageNumber();
 };
 
 #endif
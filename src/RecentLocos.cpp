@@ -0,0 +1,85 @@
+#include <RecentLocos.h>
+
+RecentLocos::RecentLocos(SdFat *sd)
+    : _sd(sd) { }
+
+LocoProfile *RecentLocos::use(uint16_t address) {
+  // Position of the address, or the oldest if it isn't recent
+  uint8_t i = 0;
+  while (i < MAX_RECENT - 1 && _addresses[i] != address) {
+    i++;
+  }
+
+  LocoProfile *profile = _addresses[i] == address ? _profiles[i] : nullptr;
+  if (_addresses[i] != address) {
+    delete _profiles[i];
+  }
+
+  // Shift the newer locos down and put this one first
+  for (; i > 0; i--) {
+    _addresses[i] = _addresses[i - 1];
+    _profiles[i] = _profiles[i - 1];
+  }
+  _addresses[0] = address;
+  _profiles[0] = profile;
+
+  if (profile == nullptr) {
+    // The current loco's profile is first so it stays while the budget is made
+    _profiles[0] = LocoProfile::load(_sd, address);
+    _loads++;
+    if (_profiles[0] == nullptr) { // Out of memory, drop the profiles that aren't on screen and try again
+      for (uint8_t j = 2; j < MAX_RECENT; j++) {
+        delete _profiles[j];
+        _profiles[j] = nullptr;
+      }
+      _profiles[0] = LocoProfile::load(_sd, address);
+    }
+  }
+  trim(2); // The previous profile may still be on screen
+
+  return _profiles[0];
+}
+
+uint16_t RecentLocos::get(uint8_t i) {
+  return i < MAX_RECENT ? _addresses[i] : 0;
+}
+
+void RecentLocos::remove(uint16_t address) {
+  for (uint8_t i = 0; i < MAX_RECENT; i++) {
+    if (_addresses[i] == address) {
+      delete _profiles[i];
+      for (; i < MAX_RECENT - 1; i++) {
+        _addresses[i] = _addresses[i + 1];
+        _profiles[i] = _profiles[i + 1];
+      }
+      _addresses[i] = 0;
+      _profiles[i] = nullptr;
+      return;
+    }
+  }
+}
+
+uint16_t RecentLocos::getLoads() {
+  return _loads;
+}
+
+void RecentLocos::trim() {
+  trim(1);
+}
+
+void RecentLocos::trim(uint8_t keep) {
+  uint16_t bytes = 0;
+  for (uint8_t i = 1; i < MAX_RECENT; i++) {
+    if (_profiles[i] != nullptr) {
+      bytes += _profiles[i]->getSize();
+    }
+  }
+
+  for (uint8_t i = MAX_RECENT - 1; i >= keep && bytes > MAX_BYTES; i--) {
+    if (_profiles[i] != nullptr) {
+      bytes -= _profiles[i]->getSize();
+      delete _profiles[i];
+      _profiles[i] = nullptr;
+    }
+  }
+}
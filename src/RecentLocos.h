@@ -0,0 +1,86 @@
+#ifndef RECENT_LOCOS_H
+#define RECENT_LOCOS_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <LocoProfile.h>
+
+/**
+ * @brief Most recently used locos with their cached `LocoProfile`s, most recent first
+ * Profiles past the byte budget are dropped oldest first and reloaded if that loco is used again,
+ * the most recent is never dropped as it's the one on screen. `use()` keeps the previous one too as it may still be
+ * shown while switching, call `trim()` once it's been replaced
+ */
+class RecentLocos {
+  public:
+    /**
+     * @brief Locos remembered
+     */
+    static const uint8_t MAX_RECENT = 4;
+    /**
+     * @brief Heap the cached profiles can use, not counting the most recent
+     */
+    static const uint16_t MAX_BYTES = 1024;
+    /**
+     * @brief Construct a new `RecentLocos` object
+     * 
+     * @param sd 
+     */
+    RecentLocos(SdFat *sd);
+    /**
+     * @brief Get a loco's profile and make it the most recent, loading it from the SD if it isn't cached
+     * The previous most recent profile isn't dropped, so it's still valid until `trim()`
+     * 
+     * @param address 
+     * @return LocoProfile* `nullptr` if there isn't the memory to load it
+     */
+    LocoProfile *use(uint16_t address);
+    /**
+     * @brief Drop the oldest profiles until those after the most recent fit `MAX_BYTES`
+     */
+    void trim();
+    /**
+     * @brief Address of a recent loco
+     * 
+     * @param i 0 is the most recent
+     * @return uint16_t 0 if there isn't one
+     */
+    uint16_t get(uint8_t i);
+    /**
+     * @brief Forget a loco, e.g. when it's released
+     * 
+     * @param address 
+     */
+    void remove(uint16_t address);
+    /**
+     * @brief Profiles loaded from the SD
+     * 
+     * @return uint16_t 
+     */
+    uint16_t getLoads();
+  private:
+    /**
+     * @brief Pointer to `SdFat` object
+     */
+    SdFat *_sd;
+    /**
+     * @brief Recent loco addresses, 0 if unused
+     */
+    uint16_t _addresses[MAX_RECENT] = { 0 };
+    /**
+     * @brief Cached profile for each address, nullptr if it isn't cached
+     */
+    LocoProfile *_profiles[MAX_RECENT] = { nullptr };
+    /**
+     * @brief Profiles loaded from the SD
+     */
+    uint16_t _loads = 0;
+    /**
+     * @brief Drop the oldest profiles until those after the most recent fit `MAX_BYTES`
+     * 
+     * @param keep Profiles at the front that aren't dropped
+     */
+    void trim(uint8_t keep);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include <RosterIndex.h>
+#include <Functions.h>
+#include <FileSort.h>
+
+const char RosterIndex::PATH[] = "/locos.idx";
+
+RosterIndex::RosterIndex(SdFat *sd)
+    : _sd(sd) { }
+
+uint16_t RosterIndex::update() {
+  uint32_t current = signature();
+  _signature = current;
+
+  Header header;
+  File file;
+  bool valid = SdCache::open(file, PATH) && file.read(&header, sizeof(header)) == sizeof(header) &&
+      memcmp_P(header.magic, PSTR("LIDX"), sizeof(header.magic)) == 0 && header.version == VERSION &&
+      header.signature == current && file.fileSize() == sizeof(Header) + (uint32_t)header.count * sizeof(Entry);
+  file.close();
+
+  if (valid) {
+    _count = header.count;
+  } else {
+    rebuild(current);
+  }
+  return _count;
+}
+
+uint16_t RosterIndex::count() {
+  return _count;
+}
+
+uint32_t RosterIndex::getSignature() {
+  return _signature;
+}
+
+uint8_t RosterIndex::read(uint16_t first, Entry *entries, uint8_t n) {
+  if (first >= _count) {
+    return 0;
+  }
+  if (n > _count - first) {
+    n = _count - first;
+  }
+
+  File file;
+  SdCache::open(file, PATH);
+  file.seekSet(sizeof(Header) + (uint32_t)first * sizeof(Entry));
+  int bytes = file.read(entries, n * sizeof(Entry));
+  file.close();
+  return bytes > 0 ? bytes / sizeof(Entry) : 0;
+}
+
+uint32_t RosterIndex::signature() {
+  uint32_t hash = FNV_BASIS;
+
+  // Only the directory entries are read, not the configs
+  FatFile locoDir = _sd->open("/locos");
+  dir_t dir;
+  while (locoDir.readDir(&dir) > 0) {
+    if (DIR_IS_FILE(&dir) && !DIR_IS_HIDDEN(&dir)) {
+      hash = fnv1a(hash, dir.name, sizeof(dir.name));
+      hash = fnv1a(hash, &dir.lastWriteDate, sizeof(dir.lastWriteDate));
+      hash = fnv1a(hash, &dir.lastWriteTime, sizeof(dir.lastWriteTime));
+      hash = fnv1a(hash, &dir.fileSize, sizeof(dir.fileSize));
+    }
+  }
+  locoDir.close();
+  return hash;
+}
+
+void RosterIndex::rebuild(uint32_t signature) {
+  File file = _sd->open(PATH, O_RDWR | O_CREAT | O_TRUNC);
+
+  // Written with no signature first, so an index cut short by a power loss is rebuilt
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy_P(header.magic, PSTR("LIDX"), sizeof(header.magic));
+  header.version = VERSION;
+  file.write(&header, sizeof(header));
+
+  StaticJsonDocument<16> filterDoc;
+  filterDoc[F("name")] = true;
+
+  _count = 0;
+  FatFile locoDir = _sd->open("/locos");
+  FatFile loco;
+  Entry entry;
+  while (_count < UINT16_MAX && loco.openNext(&locoDir, O_READ)) {
+    if (!loco.isSubDir() && !loco.isHidden()) {
+      StaticJsonDocument<64> locoDoc;
+      deserializeJson(locoDoc, loco, DeserializationOption::Filter(filterDoc));
+
+      memset(&entry, 0, sizeof(entry));
+      strlcpy(entry.name, locoDoc[F("name")] | "", sizeof(entry.name));
+      if (entry.name[0] != '\0') { // Configs without a name aren't listed
+        char buf[14] = { 0 };
+        loco.getName(buf, sizeof(buf));
+        entry.address = (uint16_t)strtoul(buf, (char **)NULL, 10);
+        file.write(&entry, sizeof(entry));
+        _count++;
+      }
+    }
+    loco.close();
+  }
+  locoDir.close();
+
+  FileSort<Entry>(file, sizeof(Header), before).sort(_count);
+
+  header.count = _count;
+  header.signature = signature;
+  file.seekSet(0);
+  file.write(&header, sizeof(header));
+  file.close();
+}
+
+bool RosterIndex::before(const Entry &a, const Entry &b) {
+  int order = strcasecmp(a.name, b.name);
+  return order < 0 || (order == 0 && a.address < b.address);
+}
@@ -0,0 +1,113 @@
+#ifndef ROSTER_INDEX_H
+#define ROSTER_INDEX_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief Binary index of the `/locos` configs sorted by name, so a page of names is a single read
+ * The index is a header then fixed size records, it's only rebuilt when the `/locos` directory entries change
+ */
+class RosterIndex {
+  public:
+    /**
+     * @brief Longest name kept, including the terminator
+     */
+    static const uint8_t NAME_SIZE = 28;
+    /**
+     * @brief An index record
+     */
+    struct Entry {
+      char name[NAME_SIZE];
+      uint16_t address;
+    };
+    /**
+     * @brief Construct a new `RosterIndex` object
+     * 
+     * @param sd 
+     */
+    RosterIndex(SdFat *sd);
+    /**
+     * @brief Check the index against `/locos` and rebuild it if the directory has changed
+     * 
+     * @return uint16_t Locos in the index
+     */
+    uint16_t update();
+    /**
+     * @brief Locos in the index
+     * 
+     * @return uint16_t 
+     */
+    uint16_t count();
+    /**
+     * @brief Signature of the `/locos` directory entries the index was last checked against, changes with the index
+     * 
+     * @return uint32_t 
+     */
+    uint32_t getSignature();
+    /**
+     * @brief Read consecutive entries, in name order
+     * 
+     * @param first 
+     * @param entries 
+     * @param n 
+     * @return uint8_t Entries read
+     */
+    uint8_t read(uint16_t first, Entry *entries, uint8_t n);
+    /**
+     * @brief FNV-1a hash of the name, size and modified time of every config in `/locos`, only the directory is read
+     * 
+     * @return uint32_t 
+     */
+    uint32_t signature();
+  private:
+    /**
+     * @brief Index file header, padded to a record
+     */
+    struct Header {
+      char magic[4];
+      uint8_t version;
+      uint8_t reserved;
+      uint16_t count;
+      uint32_t signature; // Of the `/locos` directory entries the index was built from
+      uint8_t padding[sizeof(Entry) - 12];
+    };
+    /**
+     * @brief Index file
+     */
+    static const char PATH[];
+    /**
+     * @brief Format version, a different version is rebuilt
+     */
+    static const uint8_t VERSION = 2;
+    /**
+     * @brief Pointer to `SdFat` object
+     */
+    SdFat *_sd;
+    /**
+     * @brief Locos in the index
+     */
+    uint16_t _count = 0;
+    /**
+     * @brief Signature of the `/locos` directory entries when last updated
+     */
+    uint32_t _signature = 0;
+    /**
+     * @brief Rebuild the index from the configs
+     * 
+     * @param signature 
+     */
+    void rebuild(uint32_t signature);
+    /**
+     * @brief Does a record sort before another, by name ignoring case then address
+     * 
+     * @param a 
+     * @param b 
+     * @return true 
+     * @return false 
+     */
+    static bool before(const Entry &a, const Entry &b);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include <RosterSearch.h>
+#include <FileSort.h>
+#include <SdCache.h>
+
+const char RosterSearch::PATH[] = "/search.idx";
+
+// Phone keypad digit of each letter, A - Z
+const char KEYPAD_LETTERS[] PROGMEM = "22233344455566677778889999";
+
+RosterSearch::RosterSearch(SdFat *sd, RosterIndex *roster)
+    : _sd(sd), _roster(roster) { }
+
+void RosterSearch::update() {
+  _roster->update();
+
+  Header header;
+  File file;
+  bool valid = SdCache::open(file, PATH) && file.read(&header, sizeof(header)) == sizeof(header) &&
+      memcmp_P(header.magic, PSTR("LSRC"), sizeof(header.magic)) == 0 && header.version == VERSION &&
+      header.signature == _roster->getSignature() && header.count == _roster->count() &&
+      file.fileSize() == sizeof(Header) + 2UL * header.count * sizeof(Key);
+  file.close();
+
+  if (valid) {
+    _count = header.count;
+  } else {
+    rebuild(_roster->getSignature());
+  }
+}
+
+uint16_t RosterSearch::find(SearchMode mode, const char *prefix, uint16_t &first) {
+  File file;
+  SdCache::open(file, PATH);
+  first = bound(file, mode, prefix, false);
+  uint16_t last = bound(file, mode, prefix, true);
+  file.close();
+  return last - first;
+}
+
+bool RosterSearch::read(SearchMode mode, uint16_t i, RosterIndex::Entry &entry) {
+  Key key;
+  File file;
+  SdCache::open(file, PATH);
+  file.seekSet(offset(mode, i));
+  bool read = file.read(&key, sizeof(key)) == sizeof(key);
+  file.close();
+  return read && _roster->read(key.position, &entry, 1) == 1;
+}
+
+void RosterSearch::nameKey(const char *name, char *key) {
+  uint8_t i = 0;
+  for (; name[i] != '\0' && i < KEY_SIZE - 1; i++) {
+    char c = tolower(name[i]);
+    if (c >= 'a' && c <= 'z') {
+      key[i] = pgm_read_byte(&KEYPAD_LETTERS[c - 'a']);
+    } else if (c >= '0' && c <= '9') {
+      key[i] = c;
+    } else {
+      key[i] = c == ' ' ? '0' : '1';
+    }
+  }
+  key[i] = '\0';
+}
+
+void RosterSearch::rebuild(uint32_t signature) {
+  File file = _sd->open(PATH, O_RDWR | O_CREAT | O_TRUNC);
+
+  // Written with no signature first, so an index cut short by a power loss is rebuilt
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy_P(header.magic, PSTR("LSRC"), sizeof(header.magic));
+  header.version = VERSION;
+  file.write(&header, sizeof(header));
+
+  // Both sections are written in one pass over the roster, the name keys after where the address keys end
+  _count = _roster->count();
+  RosterIndex::Entry entries[4];
+  Key key;
+  for (uint16_t position = 0; position < _count;) {
+    uint8_t n = _roster->read(position, entries, 4);
+    if (n == 0) {
+      break;
+    }
+    for (uint8_t i = 0; i < n; i++, position++) {
+      memset(&key, 0, sizeof(key));
+      key.position = position;
+      utoa(entries[i].address, key.key, 10);
+      file.seekSet(offset(SearchMode::ADDRESS, position));
+      file.write(&key, sizeof(key));
+
+      memset(&key, 0, sizeof(key));
+      key.position = position;
+      nameKey(entries[i].name, key.key);
+      file.seekSet(offset(SearchMode::NAME, position));
+      file.write(&key, sizeof(key));
+    }
+  }
+
+  FileSort<Key>(file, offset(SearchMode::ADDRESS, 0), before).sort(_count);
+  FileSort<Key>(file, offset(SearchMode::NAME, 0), before).sort(_count);
+
+  header.count = _count;
+  header.signature = signature;
+  file.seekSet(0);
+  file.write(&header, sizeof(header));
+  file.close();
+}
+
+uint32_t RosterSearch::offset(SearchMode mode, uint16_t i) {
+  return sizeof(Header) + ((uint32_t)mode * _count + i) * sizeof(Key);
+}
+
+uint16_t RosterSearch::bound(FatFile &file, SearchMode mode, const char *prefix, bool after) {
+  uint8_t length = strlen(prefix);
+  uint16_t low = 0;
+  uint16_t high = _count;
+  Key key;
+  while (low < high) {
+    uint16_t middle = low + (high - low) / 2;
+    file.seekSet(offset(mode, middle));
+    file.read(&key, sizeof(key));
+    int order = strncmp(key.key, prefix, length);
+    if (order < 0 || (after && order == 0)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+bool RosterSearch::before(const Key &a, const Key &b) {
+  int order = strcmp(a.key, b.key);
+  return order < 0 || (order == 0 && a.position < b.position);
+}
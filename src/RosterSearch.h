@@ -0,0 +1,142 @@
+#ifndef ROSTER_SEARCH_H
+#define ROSTER_SEARCH_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <RosterIndex.h>
+
+/**
+ * @brief What a `RosterSearch` prefix is matched against
+ */
+struct SearchModeEnum {
+  enum SearchModes : uint8_t {
+    ADDRESS, // Address digits
+    NAME // Name as typed on a phone keypad, 2 = ABC ... 9 = WXYZ
+  };
+};
+typedef SearchModeEnum::SearchModes SearchMode;
+
+/**
+ * @brief Prefix index of the `RosterIndex`, so the locos matching a typed prefix are found with a binary search
+ * The index holds a section of keys per `SearchMode`, each sorted so the keys sharing a prefix are together.
+ * It's built from the roster index and rebuilt when that changes
+ */
+class RosterSearch {
+  public:
+    /**
+     * @brief Longest key kept, including the terminator
+     */
+    static const uint8_t KEY_SIZE = 14;
+    /**
+     * @brief Construct a new `RosterSearch` object
+     * 
+     * @param sd 
+     * @param roster 
+     */
+    RosterSearch(SdFat *sd, RosterIndex *roster);
+    /**
+     * @brief Update the roster index, then rebuild the search index if the roster has changed
+     */
+    void update();
+    /**
+     * @brief Find the locos with keys starting with a prefix
+     * 
+     * @param mode 
+     * @param prefix Digits, empty matches every loco in key order
+     * @param first Set to the first match
+     * @return uint16_t Matches
+     */
+    uint16_t find(SearchMode mode, const char *prefix, uint16_t &first);
+    /**
+     * @brief Read the roster entry of a match
+     * 
+     * @param mode 
+     * @param i From `first` to `first` + matches - 1
+     * @param entry 
+     * @return true 
+     * @return false It couldn't be read
+     */
+    bool read(SearchMode mode, uint16_t i, RosterIndex::Entry &entry);
+    /**
+     * @brief Key a name is found by in `SearchMode::NAME`, its letters as phone keypad digits
+     * Spaces are 0 and anything other than a letter or digit is 1
+     * 
+     * @param name 
+     * @param key At least `KEY_SIZE` chars
+     */
+    static void nameKey(const char *name, char *key);
+  private:
+    /**
+     * @brief An index record
+     */
+    struct Key {
+      char key[KEY_SIZE];
+      uint16_t position; // Of the loco in the `RosterIndex`
+    };
+    /**
+     * @brief Index file header, padded to a record
+     */
+    struct Header {
+      char magic[4];
+      uint8_t version;
+      uint8_t reserved;
+      uint16_t count; // Keys in each section
+      uint32_t signature; // Of the `RosterIndex` it was built from
+      uint8_t padding[sizeof(Key) - 12];
+    };
+    /**
+     * @brief Index file
+     */
+    static const char PATH[];
+    /**
+     * @brief Format version, a different version is rebuilt
+     */
+    static const uint8_t VERSION = 1;
+    /**
+     * @brief Pointer to `SdFat` object
+     */
+    SdFat *_sd;
+    /**
+     * @brief Pointer to the `RosterIndex` searched
+     */
+    RosterIndex *_roster;
+    /**
+     * @brief Keys in each section
+     */
+    uint16_t _count = 0;
+    /**
+     * @brief Rebuild the index from the roster
+     * 
+     * @param signature 
+     */
+    void rebuild(uint32_t signature);
+    /**
+     * @brief Where a key starts
+     * 
+     * @param mode 
+     * @param i 
+     * @return uint32_t 
+     */
+    uint32_t offset(SearchMode mode, uint16_t i);
+    /**
+     * @brief Binary search a section for the first key at or after a prefix
+     * 
+     * @param file 
+     * @param mode 
+     * @param prefix 
+     * @param after Find the first key after every key with the prefix instead
+     * @return uint16_t 
+     */
+    uint16_t bound(FatFile &file, SearchMode mode, const char *prefix, bool after);
+    /**
+     * @brief Does a key sort before another
+     * 
+     * @param a 
+     * @param b 
+     * @return true 
+     * @return false 
+     */
+    static bool before(const Key &a, const Key &b);
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include <UI.h>
 
+uint16_t UI::_pageTurn = 0;
+
 UI::UI(Adafruit_SPITFT *tft)
     : _tft(tft) { }
 
@@ -12,3 +14,15 @@ int8_t UI::touch(uint16_t x, uint16_t y, Touched touched) {
 void UI::encoderChange(Rotation rotation) { }
 
 void UI::encoderPress(bool emergency) { }
+
+void UI::refresh() { }
+
+void UI::idle() { }
+
+Resume UI::getResume() {
+  return Resume();
+}
+
+uint16_t UI::getPageTurn() {
+  return _pageTurn;
+}
@@ -12,12 +12,28 @@ enum Rotation : uint8_t {
   CW
 };
 
+/**
+ * @brief Where a UI was left, enough to rebuild it in the same place
+ */
+struct Resume {
+  /**
+   * @brief No group open
+   */
+  static const uint8_t NO_GROUP = 0xFF;
+  uint16_t page = 1; // `Paging` page
+  uint8_t group = NO_GROUP; // Index of the open group in `groups.json`
+};
+
 class UI {
   protected:
     /**
      * @brief Pointer to the TFT instance
      */
     Adafruit_SPITFT *_tft;
+    /**
+     * @brief How long the last page turn took to draw, in ms
+     */
+    static uint16_t _pageTurn;
   public:
     /**
      * @brief Lambda declaration
@@ -54,6 +70,26 @@ class UI {
      * @param emergency 
      */
     virtual void encoderPress(bool emergency = false);
+    /**
+     * @brief State shown by the UI has changed outside of it, e.g. from a CS broadcast
+     */
+    virtual void refresh();
+    /**
+     * @brief Nothing else to do this loop, used to read ahead so it isn't done when the UI changes
+     */
+    virtual void idle();
+    /**
+     * @brief Where the UI is, passed back to its constructor when it's navigated back to
+     * 
+     * @return Resume 
+     */
+    virtual Resume getResume();
+    /**
+     * @brief How long the last page turn took to draw, in ms
+     * 
+     * @return uint16_t 
+     */
+    static uint16_t getPageTurn();
 };
 
 #endif
@@ -14,7 +14,15 @@
 #include <Menu.h>
 #include <LocoByAddress.h>
 #include <LocoByName.h>
+#include <LocoSearch.h>
 #include <Loco.h>
+#include <LocoTable.h>
+#include <Journal.h>
+#include <RecentLocos.h>
+#include <JsonArena.h>
+#include <FunctionMapCache.h>
+#include <SdCache.h>
+#include <Navigation.h>
 #include <Program.h>
 
 // #define THROTTLE_DEBUG
@@ -43,20 +51,30 @@ struct EncoderButtonStateEnum {
 };
 typedef EncoderButtonStateEnum::State EncoderButtonState;
 uint32_t encoderPressMillis = 0;
+uint32_t encoderHeldMillis = 0;
 uint8_t encoderBtnState = EncoderButtonState::IDLE;
 uint8_t currentEncoderPinState, lastEncoderPinState;
 
-const uint8_t MAX_LOCOS = 50;
-LocoState locos[MAX_LOCOS]; // Max 50, same as DCC++Ex
-DCCEx dcc(&Serial2); // DCC++Ex Interface
+LocoTable locos; // Max 50, same as DCC++Ex
+Journal journal; // Acquired locos saved to EEPROM
+RecentLocos recent(&sd); // Recently used locos for quick switching
+DCCEx dcc(&csSerial); // DCC++Ex Interface
+uint8_t resyncLoco = LocoTable::MAX_LOCOS; // Next active loco to replay to the CS after a reconnect, `MAX_LOCOS` when idle
+uint8_t resyncFn = 0; // Next function of `resyncLoco` to replay
 
 bool rotated = false;
 TouchRegion menu(208, 0, 32, 22); // Menu
+TouchRegion header(0, 0, 208, 22); // Loco name, switches to the previous loco
 UI *activeUI = nullptr;
+Loco *locoUI = nullptr; // `activeUI` when it's the `Loco` UI
 int8_t activeLoco = -1;
-bool isMenuUI = false;
+Screen activeScreen = Screen::MENU;
+Navigation navigation; // Screens left, so going back returns to where they were
+bool prefetch = true; // Let the active UI read ahead when there's no input
 void clearAndDrawMenuUI();
 void setMenuUI();
+void navigate(Screen screen);
+void back();
 
 #ifdef THROTTLE_DEBUG
 // https://learn.adafruit.com/memories-of-an-arduino/measuring-free-memory#sram-370031-5
@@ -80,88 +98,178 @@ int freeMemory() {
 #endif
 
 /**
- * @brief Get the index of the LocoState object
- * If the address isn't found in the `locos` array it'll add it to the first empty one
+ * @brief Update the `LocoState` from a CS broadcast, locos that haven't been acquired are ignored
  * 
  * @param address 
- * @return int8_t 
+ * @param speed 
+ * @param direction 
+ * @param functions 
  */
-int8_t getLoco(uint16_t address) {
-  int8_t firstEmpty = -1;
-  for (uint8_t i = 0; i < MAX_LOCOS; i++) {
-    if (firstEmpty == -1 && locos[i].address == 0) {
-      firstEmpty = i;
-    } else if (locos[i].address == address) {
-      return i;
-    }
+void locoBroadcast(uint16_t address, int8_t speed, uint8_t direction, uint32_t functions) {
+  int8_t i = locos.find(address);
+  if (i == -1) {
+    return;
   }
 
-  if (firstEmpty != -1) {
-    locos[firstEmpty].address = address;
+  locos[i].speed = speed;
+  locos[i].direction = direction;
+  locos[i].functions.setLow(functions);
+
+  if (i == activeLoco && activeScreen == Screen::LOCO) {
+    activeUI->refresh();
   }
-  return firstEmpty;
 }
 
 /**
- * @brief Free the `LocoState` for the address specified
+ * @brief Draw the menu burger icon, coloured by the CS link state
+ */
+void drawMenuIcon() {
+  uint16_t colour = ILI9341_WHITE;
+  if (dcc.getLinkState() == LinkState::DEGRADED) {
+    colour = ILI9341_ORANGE;
+  } else if (dcc.getLinkState() == LinkState::LOST) {
+    colour = ILI9341_RED;
+  }
+
+  tft.fillRect(208, 0, 32, 4, colour);
+  tft.fillRect(208, 9, 32, 4, colour);
+  tft.fillRect(208, 18, 32, 4, colour);
+}
+
+/**
+ * @brief CS link state changed, redraw the indicator and resync the locos if the link was lost
  * 
- * @param address 
+ * @param state 
+ * @param previous 
  */
-void freeLoco(uint16_t address) {
-  for (uint8_t i = 0; i < MAX_LOCOS; i++) {
-    if (locos[i].address == address) {
-      locos[i] = LocoState();
-      return;
-    }
+void linkStateChanged(LinkState state, LinkState previous) {
+  drawMenuIcon();
+  if (state == LinkState::CONNECTED && previous == LinkState::LOST) {
+    resyncLoco = 0;
+    resyncFn = 0;
   }
 }
 
 /**
- * @brief Draw the menu burger icon
+ * @brief Replay the speed, direction and latched functions of every acquired loco to the CS
+ * Paced by the DCCEx lanes, whatever doesn't fit is carried on with next `loop()`
  */
-void drawMenuIcon() {
-  tft.fillRect(208, 0, 32, 4, ILI9341_WHITE);
-  tft.fillRect(208, 9, 32, 4, ILI9341_WHITE);
-  tft.fillRect(208, 18, 32, 4, ILI9341_WHITE);
+void resync() {
+  for (; resyncLoco < locos.count(); resyncLoco++, resyncFn = 0) {
+    LocoState &loco = locos[locos.active(resyncLoco)];
+    if (resyncFn == 0) {
+      if (dcc.setThrottleAsync(loco.address, loco.speed, loco.direction) == -1) {
+        return;
+      }
+      resyncFn = 1;
+    }
+    // `resyncFn` is offset by 1 as 0 is the throttle
+    for (; resyncFn <= FunctionSet::MAX_FUNCTIONS; resyncFn++) {
+      if (loco.functions.test(resyncFn - 1) && !dcc.setFn(loco.address, resyncFn - 1, true)) {
+        return;
+      }
+    }
+  }
 }
 
 /**
  * @brief Change the current UI. This will clear the screen, free the current `UI` then set the new active
  * 
  * @tparam T 
+ * @param screen 
  * @param ui 
  */
 template<typename T>
-void setUI(T&& ui) {
+void setUI(Screen screen, T&& ui) {
   tft.fillRect(0, 0, 207, 22, ILI9341_BLACK);
   tft.fillRect(0, 22, 240, 298, ILI9341_BLACK);
 
   delete activeUI;
+  locoUI = nullptr;
+  activeScreen = screen;
   activeUI = ui();
 }
 
 /**
  * @brief Set the active UI to `Loco`
+ * 
+ * @param resume 
  */
-void setLocoUI() {
-  setUI([]() {
-    return new Loco(&tft, &sd, &dcc, &locos[activeLoco]);
+void setLocoUI(Resume resume = Resume()) {
+  #ifdef THROTTLE_DEBUG
+  uint32_t start = micros();
+  uint16_t loads = recent.getLoads();
+  uint16_t compiles = LocoProfile::getCompiles();
+  #endif
+  setUI(Screen::LOCO, [resume]() {
+    LocoProfile *profile = recent.use(locos[activeLoco].address);
+    return locoUI = new Loco(&tft, &sd, &dcc, &locos[activeLoco], profile, resume);
   });
+  recent.trim();
+  #ifdef THROTTLE_DEBUG
+  // Open to first paint, by where the profile came from
+  Serial.print(F("Loco UI opened in "));
+  Serial.print(micros() - start);
+  if (LocoProfile::getCompiles() != compiles) {
+    Serial.println(F("us, compiled from JSON"));
+  } else if (recent.getLoads() != loads) {
+    Serial.println(F("us, read compiled config"));
+  } else {
+    Serial.println(F("us, cached"));
+  }
+  #endif
+}
+
+/**
+ * @brief Switch the `Loco` UI to the previous loco, its profile is usually cached so the SD isn't read
+ */
+void switchLoco() {
+  int8_t slot = locos.find(recent.get(1));
+  if (locoUI == nullptr || slot == -1) {
+    return;
+  }
+
+  #ifdef THROTTLE_DEBUG
+  uint32_t start = micros();
+  uint16_t loads = recent.getLoads();
+  #endif
+  activeLoco = slot;
+  locoUI->show(&locos[activeLoco], recent.use(locos[activeLoco].address));
+  recent.trim(); // The old profile isn't shown anymore
+  #ifdef THROTTLE_DEBUG
+  Serial.print(F("Loco switched in "));
+  Serial.print(micros() - start);
+  Serial.println(recent.getLoads() != loads ? F("us, loaded from SD") : F("us, cached"));
+  #endif
+}
+
+/**
+ * @brief Open the `Loco` UI for a newly selected loco, on its first page
+ * 
+ * @param address 
+ */
+void selectLoco(uint16_t address) {
+  if (address != 0) {
+    activeLoco = locos.get(address);
+  }
+  if (activeLoco != -1) {
+    navigation.remove(Screen::LOCO);
+    navigate(Screen::LOCO);
+  }
 }
 
 /**
  * @brief Set the active UI to `LocoByAddress`
  * If an address is provided it'll be set as the active loco
- * If the KeyPad is cancelled we go back to the menu UI
+ * If the KeyPad is cancelled we go back to the previous UI
  */
 void setLocoByAddressUI() {
-  setUI([]() {
+  setUI(Screen::LOCO_BY_ADDRESS, []() {
     return new LocoByAddress(&tft, [](uint16_t value) { // Loco selected callback
       if (value != 0) {
-        activeLoco = getLoco(value);
-        setLocoUI();
+        selectLoco(value);
       } else {
-        setMenuUI();
+        back();
       }
     });
   });
@@ -170,14 +278,30 @@ void setLocoByAddressUI() {
 /**
  * @brief Set the active UI to `LocoByName`
  * If an address is provided it'll be set as the active loco
+ * 
+ * @param groups 
+ * @param resume 
  */
-void setLocoByNameUI(bool groups) {
-  setUI([groups]() {
-    return new LocoByName(&tft, &sd, groups, [](uint16_t value) { // Loco selected callback
+void setLocoByNameUI(bool groups, Resume resume = Resume()) {
+  setUI(groups ? Screen::LOCO_BY_GROUP : Screen::LOCO_BY_NAME, [groups, resume]() {
+    return new LocoByName(&tft, &sd, groups, resume, selectLoco, []() { // Search button callback
+      navigate(Screen::LOCO_SEARCH);
+    });
+  });
+}
+
+/**
+ * @brief Set the active UI to `LocoSearch`
+ * If the search is cancelled we go back to the previous UI
+ */
+void setLocoSearchUI() {
+  setUI(Screen::LOCO_SEARCH, []() {
+    return new LocoSearch(&tft, &sd, [](uint16_t value) { // Loco selected callback
       if (value != 0) {
-        activeLoco = getLoco(value);
+        selectLoco(value);
+      } else {
+        back();
       }
-      setLocoUI();
     });
   });
 }
@@ -186,7 +310,7 @@ void setLocoByNameUI(bool groups) {
  * @brief Set the active UI as `Program`
  */
 void setProgramUI() {
-  setUI([]() {
+  setUI(Screen::PROGRAM, []() {
     return new Program(&tft, &dcc);
   });
 }
@@ -196,8 +320,7 @@ void setProgramUI() {
  * The `Menu` UI has a callback for when a menu button is pressed
  */
 void setMenuUI() {
-  isMenuUI = true;
-  setUI([]() {
+  setUI(Screen::MENU, []() {
     return new Menu(&tft, [](uint8_t btn) { // Menu option callback
       switch (btn) {
         case MenuButton::ROTATE: {
@@ -209,22 +332,25 @@ void setMenuUI() {
           clearAndDrawMenuUI();
         } break;
         case MenuButton::LOCO_LOAD_BY_ADDRESS: {
-          isMenuUI = false; 
-          setLocoByAddressUI();
+          navigate(Screen::LOCO_BY_ADDRESS);
+        } break;
+        case MenuButton::LOCO_LOAD_BY_NAME: {
+          navigate(Screen::LOCO_BY_NAME);
         } break;
-        case MenuButton::LOCO_LOAD_BY_NAME:
         case MenuButton::LOCO_LOAD_BY_GROUP: {
-          isMenuUI = false; 
-          setLocoByNameUI(btn == MenuButton::LOCO_LOAD_BY_GROUP);
+          navigate(Screen::LOCO_BY_GROUP);
         } break;
         case MenuButton::LOCO_RELEASE: {
-          dcc.release(locos[activeLoco].address);
-          locos[activeLoco] = { };
-          activeLoco = -1;
+          if (activeLoco != -1) {
+            dcc.release(locos[activeLoco].address);
+            recent.remove(locos[activeLoco].address);
+            locos.free(activeLoco);
+            activeLoco = -1;
+            navigation.remove(Screen::LOCO);
+          }
         } break;
         case MenuButton::LOCO_PROGRAM: {
-          isMenuUI = false; 
-          setProgramUI();
+          navigate(Screen::PROGRAM);
         } break;
         case MenuButton::POWER_OFF_ALL: {
           dcc.powerOff(Track::ALL);
@@ -252,6 +378,68 @@ void setMenuUI() {
   });
 }
 
+/**
+ * @brief Set the active UI to a screen
+ * 
+ * @param screen 
+ * @param resume Where the screen was left
+ */
+void setScreenUI(Screen screen, Resume resume) {
+  switch (screen) {
+    case Screen::MENU: {
+      setMenuUI();
+    } break;
+    case Screen::LOCO: {
+      setLocoUI(resume);
+    } break;
+    case Screen::LOCO_BY_ADDRESS: {
+      setLocoByAddressUI();
+    } break;
+    case Screen::LOCO_BY_NAME:
+    case Screen::LOCO_BY_GROUP: {
+      setLocoByNameUI(screen == Screen::LOCO_BY_GROUP, resume);
+    } break;
+    case Screen::LOCO_SEARCH: {
+      setLocoSearchUI();
+    } break;
+    case Screen::PROGRAM: {
+      setProgramUI();
+    } break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Go to a screen, the active screen is pushed so it can be gone back to
+ * A screen that's been left before opens where it was left
+ * 
+ * @param screen 
+ */
+void navigate(Screen screen) {
+  navigation.push(activeScreen, activeUI->getResume());
+  Resume resume;
+  navigation.take(screen, resume);
+  setScreenUI(screen, resume);
+}
+
+/**
+ * @brief Go back to the last screen left, where it was left
+ * Without one we go to the `Loco` UI if there's an active loco
+ */
+void back() {
+  Navigation::Entry entry;
+  while (navigation.pop(entry)) {
+    if (entry.screen != activeScreen && (entry.screen != Screen::LOCO || activeLoco != -1)) {
+      setScreenUI(entry.screen, entry.resume);
+      return;
+    }
+  }
+  if (activeScreen != Screen::LOCO && activeLoco != -1) {
+    setLocoUI();
+  }
+}
+
 /**
  * @brief Clear the screen and redraw the menu icon and menu UI
  */
@@ -272,9 +460,13 @@ void setup() {
   // Setup interrupt for the encoder button
   pinMode(ENCODER_BTN, INPUT_PULLUP);
 
+  dcc.setLocoListener(locoBroadcast);
+  dcc.setLinkListener(linkStateChanged);
+
   if (!sd.begin(SD_CS)) {
     // TODO, print error to tft?
   }
+  SdCache::begin(&sd);
 
   // Setup the screen
   tft.begin();
@@ -287,7 +479,15 @@ void setup() {
     tft.setRotation(2);
   }
 
-  clearAndDrawMenuUI();
+  // Carry on where we were before the power was lost, the CS gets the restored locos once the link is up
+  activeLoco = journal.restore(locos);
+  if (activeLoco != -1) {
+    tft.fillScreen(ILI9341_BLACK);
+    drawMenuIcon();
+    setLocoUI();
+  } else {
+    clearAndDrawMenuUI();
+  }
 }
 
 void loop() {
@@ -299,6 +499,7 @@ void loop() {
         encoderBtnState = EncoderButtonState::PRESSED;
       } else if (currentEncoderPinState == HIGH && encoderBtnState == EncoderButtonState::PRESSED) { // Release
         encoderBtnState = EncoderButtonState::RELEASED;
+        encoderHeldMillis = millis() - encoderPressMillis;
       }
     }
     encoderPressMillis = millis();
@@ -308,6 +509,28 @@ void loop() {
   if (ts.touched()) {
     #ifdef THROTTLE_DEBUG
     Serial.println(freeMemory());
+    Serial.print(F("CS RX high water "));
+    Serial.print(csSerial.getRxHighWater());
+    Serial.print(F(" dropped "));
+    Serial.println(csSerial.getRxDropped());
+    Serial.print(F("JSON arena peak "));
+    Serial.print(JsonArena::getPeak());
+    Serial.print(F(" of "));
+    Serial.print(JsonArena::SIZE);
+    Serial.print(F(" failures "));
+    Serial.println(JsonArena::getFailures());
+    Serial.print(F("Function map cache hits "));
+    Serial.print(FunctionMapCache::getHits());
+    Serial.print(F(" misses "));
+    Serial.println(FunctionMapCache::getMisses());
+    Serial.print(F("SD cache hits "));
+    Serial.print(SdCache::getHits());
+    Serial.print(F(" misses "));
+    Serial.println(SdCache::getMisses());
+    Serial.print(F("Last page turn "));
+    Serial.print(UI::getPageTurn());
+    Serial.print(F("ms prefetch "));
+    Serial.println(prefetch ? F("on") : F("off"));
     #endif
     // Remap the touch point
     tp = ts.getPoint(); 
@@ -323,14 +546,16 @@ void loop() {
       while (ts.touched()) {
         delay(50);
       }
-      if (isMenuUI) { // If the menu is the current UI and we have an active loco we switch to the `Loco` UI
-        if (activeLoco != -1) {
-          isMenuUI = false;
-          setLocoUI();
-        }
+      if (activeScreen == Screen::MENU) { // If the menu is the current UI we go back to where we were
+        back();
       } else { // If current UI isn't `Menu` then switch to that
-        setMenuUI();
+        navigate(Screen::MENU);
       }
+    } else if (locoUI != nullptr && header.contains(tp)) { // Loco name press, quick switch
+      while (ts.touched()) {
+        delay(50);
+      }
+      switchLoco();
     } else { // Send the touch to the active UI
       activeUI->touch(tp.x, tp.y, []() { return ts.touched(); });
     }
@@ -346,13 +571,34 @@ void loop() {
   } else if (encoderBtnState == EncoderButtonState::PRESSED && millis() - encoderPressMillis > 2000) { // Encoder pressed and held for more than 2 seconds
     encoderBtnState = EncoderButtonState::IDLE;
     dcc.emergencyStopAll(); // Stop all locos
-    for (uint8_t i = 0; i < MAX_LOCOS; i++) { // Reset all loco speeds to zero
-      locos[i].speed = 0;
+    for (uint8_t i = 0; i < locos.count(); i++) { // Reset all loco speeds to zero
+      locos[locos.active(i)].speed = 0;
     }
     activeUI->encoderPress(true);
+  } else if (encoderBtnState == EncoderButtonState::RELEASED && encoderHeldMillis >= 1000) { // Encoder held for 1 - 2 seconds
+    encoderBtnState = EncoderButtonState::IDLE;
+    switchLoco();
   } else if (encoderBtnState == EncoderButtonState::RELEASED && millis() - encoderPressMillis < 1000) { // Encoder pressed for less than 1 second
     encoderBtnState = EncoderButtonState::IDLE;
     activeUI->encoderPress();
+  } else if (prefetch) { // No input, read ahead
+    activeUI->idle();
   }
-  dcc.clearCSResponse();
+  dcc.loop();
+  resync();
+  journal.loop(locos, activeLoco != -1 ? locos[activeLoco].address : 0);
+
+  #ifdef THROTTLE_DEBUG
+  // `t` dumps the CS link trace, `r` resets it, `p` turns prefetch on and off to compare page turns
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 't') {
+      dcc.dumpTrace(Serial);
+    } else if (c == 'r') {
+      dcc.resetTrace();
+    } else if (c == 'p') {
+      prefetch = !prefetch;
+    }
+  }
+  #endif
 }
@@ -0,0 +1,66 @@
+// CS command formatting, `sprintf_P` into a buffer then copied into a lane against `CommandQueue` (user-006)
+//
+//   g++ -std=gnu++17 -O2 -Itest/bench/stubs -Isrc test/bench/command_bench.cpp test/bench/host.cpp src/CommandQueue.cpp -o command_bench
+//
+// Times are per command and include the queue commit and pop both paths pay
+
+#include <CommandQueue.h>
+#include <chrono>
+
+static uint8_t buffer[96];
+static CommandQueue queue(buffer, sizeof(buffer));
+
+template<class F> static double bench(F format) {
+  const long ROUNDS = 5000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < ROUNDS; i++) {
+    queue.begin();
+    format(i);
+    queue.commit(0xFF);
+    queue.pop();
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / ROUNDS;
+}
+
+static void putString(const char *s) {
+  while (*s != '\0') {
+    queue.put(*s++);
+  }
+}
+
+int main() {
+  char buf[32];
+  struct {
+    const char *name;
+    double sprintf;
+    double formatter;
+  } results[] = {
+    { "<t 1 addr speed dir>",
+      bench([&](long i) { sprintf_P(buf, PSTR("<t 1 %d %d %d>"), (int)(i & 0x3FFF), (int)(i & 127), (int)(i & 1)); putString(buf); }),
+      bench([&](long i) {
+        queue.put('<'); queue.put('t'); queue.put(' '); queue.putNumber(1); queue.put(' '); queue.putNumber(i & 0x3FFF);
+        queue.put(' '); queue.putNumber(i & 127); queue.put(' '); queue.putNumber(i & 1); queue.put('>');
+      }) },
+    { "<F addr fn state>",
+      bench([&](long i) { sprintf_P(buf, PSTR("<F %d %d %d>"), (int)(i & 0x3FFF), (int)(i & 63), (int)(i & 1)); putString(buf); }),
+      bench([&](long i) {
+        queue.put('<'); queue.put('F'); queue.put(' '); queue.putNumber(i & 0x3FFF); queue.put(' '); queue.putNumber(i & 63);
+        queue.put(' '); queue.putNumber(i & 1); queue.put('>');
+      }) },
+    { "<- addr>",
+      bench([&](long i) { sprintf_P(buf, PSTR("<- %d>"), (int)(i & 0x3FFF)); putString(buf); }),
+      bench([&](long i) { queue.put('<'); queue.put('-'); queue.put(' '); queue.putNumber(i & 0x3FFF); queue.put('>'); }) },
+    { "<W cv value 12345 32767>",
+      bench([&](long i) { sprintf_P(buf, PSTR("<W %d %d 12345 32767>"), (int)(i & 1023), (int)(i & 255)); putString(buf); }),
+      bench([&](long i) {
+        queue.put('<'); queue.put('W'); queue.put(' '); queue.putNumber(i & 1023); queue.put(' '); queue.putNumber(i & 255);
+        queue.put(' '); queue.putNumber(12345); queue.put(' '); queue.putNumber(32767); queue.put('>');
+      }) },
+  };
+
+  printf("%-26s %11s %13s\n", "command", "sprintf ns", "formatter ns");
+  for (auto &result : results) {
+    printf("%-26s %11.1f %13.1f\n", result.name, result.sprintf, result.formatter);
+  }
+  return 0;
+}
@@ -0,0 +1,44 @@
+// Host stand-ins for the Arduino core, the CS serial fakes record what was written to `txLog` and read from `rxData`
+
+#include <Arduino.h>
+#include <string>
+unsigned long fakeMillis = 0, fakeMicros = 0;
+unsigned long millis() { return fakeMillis; }
+unsigned long micros() { return fakeMicros ? fakeMicros : fakeMillis * 1000; }
+void delay(unsigned long d) { fakeMillis += d; }
+std::string txLog, rxData; size_t rxPos = 0;
+size_t Print::print(const __FlashStringHelper *s) { return write((const char*)s); }
+size_t Print::print(const char *s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int n, int) { return print(std::to_string(n).c_str()); }
+size_t Print::print(unsigned int n, int) { return print(std::to_string(n).c_str()); }
+size_t Print::print(long n, int) { return print(std::to_string(n).c_str()); }
+size_t Print::print(unsigned long n, int) { return print(std::to_string(n).c_str()); }
+size_t Print::print(unsigned char n, int) { return print(std::to_string(n).c_str()); }
+size_t Print::println() { return write("\n"); }
+size_t Print::println(const __FlashStringHelper *s) { return print(s) + println(); }
+size_t Print::println(const char *s) { return print(s) + println(); }
+size_t Print::println(char s) { return print(s) + println(); }
+size_t Print::println(int s, int) { return print(s) + println(); }
+size_t Print::println(unsigned int s, int) { return print(s) + println(); }
+size_t Print::println(long s, int) { return print(s) + println(); }
+size_t Print::println(unsigned long s, int) { return print(s) + println(); }
+size_t Print::println(unsigned char s, int) { return print(s) + println(); }
+void HardwareSerial::begin(unsigned long) {}
+int HardwareSerial::available() { return rxData.size() - rxPos; }
+int HardwareSerial::read() { return rxPos < rxData.size() ? (uint8_t)rxData[rxPos++] : -1; }
+int HardwareSerial::peek() { return rxPos < rxData.size() ? (uint8_t)rxData[rxPos] : -1; }
+size_t HardwareSerial::write(uint8_t c) { txLog += (char)c; return 1; }
+int fakeTxFree = 63; int HardwareSerial::availableForWrite() { return fakeTxFree; }
+HardwareSerial Serial, Serial2;
+#ifndef REAL_CS_SERIAL
+#include <CSSerial.h>
+void CSSerial::begin(uint32_t) {}
+int CSSerial::available() { return rxData.size() - rxPos; }
+int CSSerial::read() { return rxPos < rxData.size() ? (uint8_t)rxData[rxPos++] : -1; }
+int CSSerial::peek() { return rxPos < rxData.size() ? (uint8_t)rxData[rxPos] : -1; }
+size_t CSSerial::write(uint8_t c) { txLog += (char)c; return 1; }
+int CSSerial::availableForWrite() { return fakeTxFree; }
+void CSSerial::flush() {}
+CSSerial csSerial;
+#endif
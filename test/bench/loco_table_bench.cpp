@@ -0,0 +1,108 @@
+// Loco slot lookups, `LocoTable` against the scan over `locos[]` it replaced (user-012)
+//
+//   g++ -std=gnu++17 -O2 -Itest/bench/stubs -Isrc -Ilib/TouchButton -Ilib/TouchRegion -Ilib/SdCache -Ilib/IconAtlas test/bench/loco_table_bench.cpp test/bench/host.cpp src/LocoTable.cpp -o loco_table_bench
+//
+// Lookups are half hits and half misses. A random get/free sequence is checked against the scan first
+
+#include <LocoTable.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+static LocoState locos[LocoTable::MAX_LOCOS];
+
+// The `findLoco()` scan from `main.cpp`
+__attribute__((noinline)) static int8_t scan(uint16_t address) {
+  if (address == 0) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < LocoTable::MAX_LOCOS; i++) {
+    if (locos[i].address == address) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool fuzz(std::mt19937 &rng) {
+  LocoTable table;
+  for (long n = 0; n < 200000; n++) {
+    uint16_t address = rng() % 120 + 1;
+    bool add = rng() % 3 == 0;
+    int8_t slot = table.find(address);
+    int8_t scanned = scan(address);
+    if ((slot == -1) != (scanned == -1)) {
+      printf("MISMATCH %u\n", address);
+      return false;
+    }
+    if (add && slot == -1 && table.get(address) != -1) {
+      for (auto &loco : locos) {
+        if (loco.address == 0) {
+          loco.address = address;
+          break;
+        }
+      }
+    } else if (!add && slot != -1 && rng() % 2 == 0) {
+      table.free(slot);
+      locos[scanned] = LocoState();
+    }
+  }
+
+  uint8_t count = 0;
+  for (auto &loco : locos) {
+    count += loco.address != 0;
+  }
+  if (count != table.count()) {
+    printf("MISMATCH count %u, table %u\n", count, table.count());
+    return false;
+  }
+  printf("200000 gets, frees and lookups agreed with the scan\n");
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(1);
+  if (!fuzz(rng)) {
+    return 1;
+  }
+
+  const long ROUNDS = 2000;
+  printf("%-10s %8s %9s\n", "active", "scan ns", "table ns");
+  for (uint8_t active : { 1, 10, 50 }) {
+    LocoTable *table = new LocoTable;
+    for (auto &loco : locos) {
+      loco = LocoState();
+    }
+    std::vector<uint16_t> addresses;
+    for (uint8_t i = 0; i < active; i++) {
+      uint16_t address = 3 + i * 7;
+      table->get(address);
+      locos[i * LocoTable::MAX_LOCOS / active].address = address;
+      addresses.push_back(address);
+    }
+    std::vector<uint16_t> lookups;
+    for (int i = 0; i < 4096; i++) {
+      lookups.push_back(i & 1 ? addresses[rng() % active] : rng() % 9999 + 1);
+    }
+
+    volatile long sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (long r = 0; r < ROUNDS; r++) {
+      for (uint16_t address : lookups) {
+        sink += scan(address);
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (long r = 0; r < ROUNDS; r++) {
+      for (uint16_t address : lookups) {
+        sink += table->find(address);
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    double lookupCount = ROUNDS * (double)lookups.size();
+    printf("%-10u %8.1f %9.1f\n", active, std::chrono::duration<double, std::nano>(t1 - t0).count() / lookupCount,
+      std::chrono::duration<double, std::nano>(t2 - t1).count() / lookupCount);
+    delete table;
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+// CS response parsing, `DCCExParser` against the Regexp `MatchState` path it replaced (user-002)
+//
+//   g++ -std=gnu++17 -O2 -Itest/bench/stubs -Isrc test/bench/parser_bench.cpp test/bench/host.cpp src/DCCExParser.cpp -o parser_bench
+//
+// Both paths see the same replies. The old path is the one in `DCCEx` before the parser: the line is read into a
+// zeroed buffer, the pattern copied out of PROGMEM, matched, then the captures converted with `strtol`/`strtoul`
+
+#include <DCCExParser.h>
+#include <Regexp.h>
+#include <chrono>
+
+struct Reply {
+  const char *line;
+  const char *pattern;
+  uint8_t bufferSize; // As sized in the old `DCCEx` methods
+  uint8_t patternSize;
+};
+
+static const Reply REPLIES[] = {
+  { "<T 1 45 1>\n", "<T 1 (%d+) (%d+)>", 18, 18 },
+  { "<r12345|32767|29 6>\n", "<r12345|32767|(%d+) (%d+)>", 24, 27 },
+  { "<w 3>\n", "<w (%d+)>", 10, 10 },
+  { "<r 3>\n", "<r (%d+)>", 10, 10 },
+  { "<r12345|32767|29 1 1>\n", "<r12345|32767|(%d+) (%d+) (%d+)>", 25, 33 },
+};
+static const uint8_t REPLY_COUNT = sizeof(REPLIES) / sizeof(REPLIES[0]);
+
+static volatile long sink;
+
+__attribute__((noinline)) static long matchOld(const Reply &reply) {
+  char buf[25];
+  memset(buf, 0, reply.bufferSize);
+  for (uint8_t i = 0; reply.line[i] != '\n' && i < reply.bufferSize - 1; i++) { // readBytesUntil('\n', ...)
+    buf[i] = reply.line[i];
+  }
+  MatchState ms(buf, reply.bufferSize);
+  char pattern[33];
+  strncpy_P(pattern, reply.pattern, reply.patternSize);
+
+  long sum = 0;
+  if (ms.Match(pattern) == REGEXP_MATCHED) {
+    for (int i = 0; i < ms.level; i++) {
+      sum += strtol(ms.capture[i].init, (char **)NULL, 10);
+    }
+  }
+  return sum;
+}
+
+__attribute__((noinline)) static long matchNew(DCCExParser &parser, const Reply &reply) {
+  long sum = 0;
+  for (const char *c = reply.line; *c != '\0'; c++) {
+    if (parser.parse(*c)) {
+      const DCCExFrame &frame = parser.frame();
+      for (uint8_t i = 0; i < frame.count && i < DCCExFrame::MAX_FIELDS; i++) {
+        sum += frame.fields[i];
+      }
+    }
+  }
+  return sum;
+}
+
+int main() {
+  // Both paths have to agree before they're timed, the old one skips the fixed `T 1` and `12345|32767|` fields
+  static const long FIXED[REPLY_COUNT] = { 1, 12345 + 32767, 0, 0, 12345 + 32767 };
+  DCCExParser parser;
+  for (uint8_t i = 0; i < REPLY_COUNT; i++) {
+    long before = matchOld(REPLIES[i]);
+    long after = matchNew(parser, REPLIES[i]) - FIXED[i];
+    if (before != after) {
+      printf("MISMATCH %.*s: old %ld, parser %ld\n", (int)strlen(REPLIES[i].line) - 1, REPLIES[i].line, before, after);
+      return 1;
+    }
+  }
+
+  const long ROUNDS = 1000000;
+  printf("%-24s %10s %10s\n", "reply", "Regexp ns", "parser ns");
+  for (uint8_t i = 0; i < REPLY_COUNT; i++) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (long n = 0; n < ROUNDS; n++) {
+      sink += matchOld(REPLIES[i]);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (long n = 0; n < ROUNDS; n++) {
+      sink += matchNew(parser, REPLIES[i]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    printf("%-24.*s %10.1f %10.1f\n", (int)strlen(REPLIES[i].line) - 1, REPLIES[i].line,
+      std::chrono::duration<double, std::nano>(t1 - t0).count() / ROUNDS,
+      std::chrono::duration<double, std::nano>(t2 - t1).count() / ROUNDS);
+  }
+  return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+#include <Arduino.h>
+class TS_Point { public: int16_t x, y, z; };
+class Adafruit_FT6206 { public: bool begin(); uint8_t touched(); TS_Point getPoint(); };
@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+typedef struct { uint16_t bitmapOffset; uint8_t width, height, xAdvance; int8_t xOffset, yOffset; } GFXglyph;
+typedef struct { uint8_t *bitmap; GFXglyph *glyph; uint16_t first, last; uint8_t yAdvance; } GFXfont;
+class Adafruit_GFX : public Print {
+public:
+  size_t write(uint8_t) override;
+  void fillRect(int16_t, int16_t, int16_t, int16_t, uint16_t); void fillScreen(uint16_t);
+  void drawRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t);
+  void fillRoundRect(int16_t, int16_t, int16_t, int16_t, int16_t, uint16_t);
+  void drawFastHLine(int16_t, int16_t, int16_t, uint16_t);
+  void fillCircle(int16_t, int16_t, int16_t, uint16_t);
+  void setCursor(int16_t, int16_t); void setTextColor(uint16_t); void setTextColor(uint16_t, uint16_t); void setTextSize(uint8_t);
+  void setFont(const GFXfont *); void setRotation(uint8_t);
+  void getTextBounds(const char *, int16_t, int16_t, int16_t *, int16_t *, uint16_t *, uint16_t *);
+  void getTextBounds(const __FlashStringHelper *, int16_t, int16_t, int16_t *, int16_t *, uint16_t *, uint16_t *);
+  int16_t width(); int16_t height();
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <Adafruit_SPITFT.h>
+#define ILI9341_BLACK 0x0000
+#define ILI9341_WHITE 0xFFFF
+#define ILI9341_DARKGREY 0x7BEF
+#define ILI9341_LIGHTGREY 0xC618
+#define ILI9341_DARKGREEN 0x03E0
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_RED 0xF800
+#define ILI9341_ORANGE 0xFD20
+#define ILI9341_YELLOW 0xFFE0
+class Adafruit_ILI9341 : public Adafruit_SPITFT { public: Adafruit_ILI9341(int8_t, int8_t); void begin(); };
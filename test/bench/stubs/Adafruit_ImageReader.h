@@ -0,0 +1,5 @@
+#pragma once
+#include <SdFat.h>
+#include <Adafruit_SPITFT.h>
+enum ImageReturnCode { IMAGE_SUCCESS, IMAGE_ERR_FILE_NOT_FOUND, IMAGE_ERR_FORMAT, IMAGE_ERR_MALLOC };
+class Adafruit_ImageReader { public: Adafruit_ImageReader(SdFat &); ImageReturnCode drawBMP(const char *, Adafruit_SPITFT &, int16_t, int16_t, bool = true); ImageReturnCode bmpDimensions(const char *, int32_t *, int32_t *); };
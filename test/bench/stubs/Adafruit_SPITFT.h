@@ -0,0 +1,12 @@
+#pragma once
+#include <Adafruit_GFX.h>
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+  void startWrite(); void endWrite(); virtual void setAddrWindow(uint16_t, uint16_t, uint16_t, uint16_t);
+  void writePixels(uint16_t *, uint32_t, bool = true, bool = false);
+  void writePixel(int16_t, int16_t, uint16_t);
+  void writeColor(uint16_t, uint32_t);
+  void writeFillRect(int16_t, int16_t, int16_t, int16_t, uint16_t);
+  void drawRGBBitmap(int16_t, int16_t, uint16_t *, int16_t, int16_t);
+  static uint16_t color565(uint8_t, uint8_t, uint8_t);
+};
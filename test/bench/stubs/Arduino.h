@@ -0,0 +1,77 @@
+#pragma once
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#define PROGMEM
+#define PSTR(s) (s)
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define strncpy_P strncpy
+#define strcpy_P strcpy
+inline size_t strlcpy(char *d, const char *s, size_t n) { size_t l = strlen(s); if (n) { size_t c = l < n - 1 ? l : n - 1; memcpy(d, s, c); d[c] = 0; } return l; }
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#include <strings.h>
+#include <stdint.h>
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define INPUT_PULLUP 2
+#define LOW 0
+#define HIGH 1
+#define A12 66
+typedef bool boolean;
+typedef uint8_t byte;
+unsigned long millis(); unsigned long micros(); void delay(unsigned long);
+int digitalRead(uint8_t); void pinMode(uint8_t, uint8_t);
+long map(long, long, long, long, long);
+template<class T, class U> auto min(T a, U b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template<class T, class U> auto max(T a, U b) -> decltype(a > b ? a : b) { return a > b ? a : b; }
+template<class T, class L, class H> T constrain(T a, L l, H h) { return a < l ? l : (a > h ? h : a); }
+#define DEC 10
+#define HEX 16
+class Print {
+public:
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *b, size_t n) { size_t r=0; while(n--) r+=write(*b++); return r; }
+  size_t write(const char *s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char *s, size_t n) { return write((const uint8_t*)s, n); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+  size_t print(const __FlashStringHelper *); size_t print(const char *); size_t print(char);
+  size_t print(int, int = DEC); size_t print(unsigned int, int = DEC); size_t print(long, int = DEC); size_t print(unsigned long, int = DEC);
+  size_t print(unsigned char, int = DEC);
+  size_t println(const __FlashStringHelper *); size_t println(const char *); size_t println(char);
+  size_t println(int, int = DEC); size_t println(unsigned int, int = DEC); size_t println(long, int = DEC); size_t println(unsigned long, int = DEC);
+  size_t println(unsigned char, int = DEC);
+  size_t println();
+};
+class Stream : public Print {
+public:
+  virtual int available() = 0; virtual int read() = 0; virtual int peek() = 0;
+  void setTimeout(unsigned long);
+  size_t readBytesUntil(char, char *, size_t);
+};
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long);
+  int available() override; int read() override; int peek() override; size_t write(uint8_t) override;
+  int availableForWrite() override;
+  using Print::write;
+  operator bool() { return true; }
+};
+extern HardwareSerial Serial, Serial2;
+#define SERIAL_TX_BUFFER_SIZE 64
+#include <ctype.h>
+#ifndef STUB_UTOA
+#define STUB_UTOA
+inline char *utoa(unsigned v, char *s, int radix) { sprintf(s, radix == 16 ? "%x" : "%u", v); return s; }
+#endif
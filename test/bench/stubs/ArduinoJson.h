@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+struct JsonString { const char *c_str() const; };
+
+struct JsonVariant {
+  template<class K> JsonVariant operator[](K) const;
+  template<class T> T as() const; template<class T> bool is() const; template<class T> T to();
+  template<class T> operator T() const;
+  template<class T> T operator|(T) const;
+  const char *operator|(const char *) const;
+  template<class T> JsonVariant &operator=(const T &);
+  template<class K> bool containsKey(K) const;
+  size_t size() const; void clear();
+  JsonVariant createNestedArray() const; JsonVariant createNestedObject() const;
+  template<class K> JsonVariant createNestedArray(K) const; template<class K> JsonVariant createNestedObject(K) const;
+  JsonVariant add() const; template<class T> bool add(T) const;
+  bool isNull() const;
+  JsonVariant *begin() const; JsonVariant *end() const;
+  JsonString key() const; JsonVariant value() const;
+};
+typedef JsonVariant JsonArray; typedef JsonVariant JsonObject; typedef JsonVariant JsonArrayConst; typedef JsonVariant JsonObjectConst; typedef JsonVariant JsonVariantConst; typedef JsonVariant JsonPair;
+struct DeserializationError { enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep }; DeserializationError(Code = Ok); operator bool() const; Code code() const; const char *c_str() const; bool operator==(Code) const; bool operator!=(Code) const; };
+struct JsonDocument : JsonVariant { size_t memoryUsage() const; size_t capacity() const; bool overflowed() const; JsonVariant as_() const; void shrinkToFit(); void garbageCollect(); };
+template<size_t N> struct StaticJsonDocument : JsonDocument {};
+template<class A> struct BasicJsonDocument : JsonDocument { explicit BasicJsonDocument(size_t, A = A()); ~BasicJsonDocument(); };
+struct DynamicJsonDocument : JsonDocument { explicit DynamicJsonDocument(size_t); };
+namespace DeserializationOption { struct Filter { Filter(JsonVariant); }; struct NestingLimit { NestingLimit(uint8_t); }; }
+template<class S> DeserializationError deserializeJson(JsonDocument &, S &);
+template<class S> DeserializationError deserializeJson(JsonDocument &, S &, DeserializationOption::Filter);
+template<class S> DeserializationError deserializeJson(JsonDocument &, S *);
+template<class S> DeserializationError deserializeJson(JsonDocument &, S *, DeserializationOption::Filter);
@@ -0,0 +1,3 @@
+#pragma once
+#include <Arduino.h>
+class Encoder { public: Encoder(uint8_t, uint8_t); int32_t read(); void write(int32_t); };
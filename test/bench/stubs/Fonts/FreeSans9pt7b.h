@@ -0,0 +1,3 @@
+#pragma once
+#include <Adafruit_GFX.h>
+extern const GFXfont FreeSans9pt7b;
@@ -0,0 +1,344 @@
+#ifndef REGEXP_H
+#define REGEXP_H
+
+// Host stand-in for the nickgammon/Regexp library the CS responses were matched with before `DCCExParser`.
+// That library is a port of the Lua 5.1 pattern matcher (lstrlib.c), this is the same algorithm with the
+// same `MatchState` interface so the old parsing path can be timed against the parser
+
+#include <ctype.h>
+#include <string.h>
+
+#define MAXCAPTURES 32
+#define CAP_UNFINISHED (-1)
+#define CAP_POSITION (-2)
+#define L_ESC '%'
+#define SPECIALS "^$*+?.([%-"
+
+#define REGEXP_MATCHED 1
+#define REGEXP_NOMATCH 0
+#define ERR_NONE 0
+#define ERR_PATTERN (-1)
+
+struct Capture {
+  const char *init;
+  int len;
+};
+
+class MatchState {
+  public:
+    const char *src; // Target string
+    unsigned int src_len;
+    const char *src_end;
+    const char *pattern;
+    int level; // Captures found
+    int MatchStart;
+    int MatchLength;
+    char result;
+    Capture capture[MAXCAPTURES];
+
+    MatchState(char *s, unsigned int len)
+        : src(s), src_len(len), src_end(s + len), pattern(nullptr), level(0), MatchStart(0), MatchLength(0),
+          result(REGEXP_NOMATCH) { }
+
+    /**
+     * Find the first match of a pattern at or after `index`, like Lua's `string.find`
+     */
+    char Match(const char *p, unsigned int index = 0) {
+      pattern = p;
+      result = ERR_NONE;
+      bool anchor = *p == '^';
+      if (anchor) {
+        p++;
+      }
+      const char *s = src + index;
+      do {
+        level = 0;
+        const char *e = match(s, p);
+        if (result < 0) {
+          return result;
+        }
+        if (e != nullptr) {
+          MatchStart = s - src;
+          MatchLength = e - s;
+          return REGEXP_MATCHED;
+        }
+      } while (s++ < src_end && !anchor);
+      return REGEXP_NOMATCH;
+    }
+
+  private:
+    int check_capture(int l) {
+      l -= '1';
+      if (l < 0 || l >= level || capture[l].len == CAP_UNFINISHED) {
+        result = ERR_PATTERN;
+        return 0;
+      }
+      return l;
+    }
+
+    int capture_to_close() {
+      int l = level;
+      for (l--; l >= 0; l--) {
+        if (capture[l].len == CAP_UNFINISHED) {
+          return l;
+        }
+      }
+      result = ERR_PATTERN;
+      return 0;
+    }
+
+    const char *classEnd(const char *p) {
+      switch (*p++) {
+        case L_ESC:
+          if (*p == '\0') {
+            result = ERR_PATTERN;
+            return p;
+          }
+          return p + 1;
+        case '[':
+          if (*p == '^') {
+            p++;
+          }
+          do { // Look for a `]`
+            if (*p == '\0') {
+              result = ERR_PATTERN;
+              return p;
+            }
+            if (*(p++) == L_ESC && *p != '\0') {
+              p++; // Skip escapes (e.g. `%]`)
+            }
+          } while (*p != ']');
+          return p + 1;
+        default:
+          return p;
+      }
+    }
+
+    static int match_class(int c, int cl) {
+      int res;
+      switch (tolower(cl)) {
+        case 'a': res = isalpha(c); break;
+        case 'c': res = iscntrl(c); break;
+        case 'd': res = isdigit(c); break;
+        case 'l': res = islower(c); break;
+        case 'p': res = ispunct(c); break;
+        case 's': res = isspace(c); break;
+        case 'u': res = isupper(c); break;
+        case 'w': res = isalnum(c); break;
+        case 'x': res = isxdigit(c); break;
+        default: return cl == c;
+      }
+      if (isupper(cl)) {
+        res = !res;
+      }
+      return res;
+    }
+
+    static int matchbracketclass(int c, const char *p, const char *ec) {
+      int sig = 1;
+      if (*(p + 1) == '^') {
+        sig = 0;
+        p++; // Skip the `^`
+      }
+      while (++p < ec) {
+        if (*p == L_ESC) {
+          p++;
+          if (match_class(c, (unsigned char)*p)) {
+            return sig;
+          }
+        } else if (*(p + 1) == '-' && p + 2 < ec) {
+          p += 2;
+          if ((unsigned char)*(p - 2) <= c && c <= (unsigned char)*p) {
+            return sig;
+          }
+        } else if ((unsigned char)*p == c) {
+          return sig;
+        }
+      }
+      return !sig;
+    }
+
+    static int singlematch(int c, const char *p, const char *ep) {
+      switch (*p) {
+        case '.': return 1; // Matches any char
+        case L_ESC: return match_class(c, (unsigned char)*(p + 1));
+        case '[': return matchbracketclass(c, p, ep - 1);
+        default: return (unsigned char)*p == c;
+      }
+    }
+
+    const char *matchbalance(const char *s, const char *p) {
+      if (*p == 0 || *(p + 1) == 0) {
+        result = ERR_PATTERN;
+        return nullptr;
+      }
+      if (*s != *p) {
+        return nullptr;
+      }
+      int b = *p;
+      int e = *(p + 1);
+      int cont = 1;
+      while (++s < src_end) {
+        if (*s == e) {
+          if (--cont == 0) {
+            return s + 1;
+          }
+        } else if (*s == b) {
+          cont++;
+        }
+      }
+      return nullptr; // String ends out of balance
+    }
+
+    const char *max_expand(const char *s, const char *p, const char *ep) {
+      int i = 0; // Counts maximum expand for item
+      while (s + i < src_end && singlematch((unsigned char)*(s + i), p, ep)) {
+        i++;
+      }
+      while (i >= 0) { // Keeps trying to match with the maximum repetitions
+        const char *res = match(s + i, ep + 1);
+        if (res != nullptr) {
+          return res;
+        }
+        i--; // Else didn't match, reduce 1 repetition to try again
+      }
+      return nullptr;
+    }
+
+    const char *min_expand(const char *s, const char *p, const char *ep) {
+      for (;;) {
+        const char *res = match(s, ep + 1);
+        if (res != nullptr) {
+          return res;
+        } else if (s < src_end && singlematch((unsigned char)*s, p, ep)) {
+          s++; // Try with one more repetition
+        } else {
+          return nullptr;
+        }
+      }
+    }
+
+    const char *start_capture(const char *s, const char *p, int what) {
+      if (level >= MAXCAPTURES) {
+        result = ERR_PATTERN;
+        return nullptr;
+      }
+      capture[level].init = s;
+      capture[level].len = what;
+      level++;
+      const char *res = match(s, p);
+      if (res == nullptr) { // Match failed, undo capture
+        level--;
+      }
+      return res;
+    }
+
+    const char *end_capture(const char *s, const char *p) {
+      int l = capture_to_close();
+      capture[l].len = s - capture[l].init; // Close capture
+      const char *res = match(s, p);
+      if (res == nullptr) { // Match failed, undo capture
+        capture[l].len = CAP_UNFINISHED;
+      }
+      return res;
+    }
+
+    const char *match_capture(const char *s, int l) {
+      l = check_capture(l);
+      size_t len = capture[l].len;
+      if ((size_t)(src_end - s) >= len && memcmp(capture[l].init, s, len) == 0) {
+        return s + len;
+      }
+      return nullptr;
+    }
+
+    const char *match(const char *s, const char *p) {
+      for (;;) {
+        if (result < 0) {
+          return nullptr;
+        }
+        switch (*p) {
+          case '(': // Start capture
+            if (*(p + 1) == ')') { // Position capture
+              return start_capture(s, p + 2, CAP_POSITION);
+            }
+            return start_capture(s, p + 1, CAP_UNFINISHED);
+          case ')': // End capture
+            return end_capture(s, p + 1);
+          case L_ESC:
+            switch (*(p + 1)) {
+              case 'b': // Balanced string
+                s = matchbalance(s, p + 2);
+                if (s == nullptr) {
+                  return nullptr;
+                }
+                p += 4;
+                continue;
+              case 'f': { // Frontier
+                p += 2;
+                if (*p != '[') {
+                  result = ERR_PATTERN;
+                  return nullptr;
+                }
+                const char *ep = classEnd(p); // Points to what is next
+                char previous = s == src ? '\0' : *(s - 1);
+                if (matchbracketclass((unsigned char)previous, p, ep - 1) ||
+                    !matchbracketclass((unsigned char)*s, p, ep - 1)) {
+                  return nullptr;
+                }
+                p = ep;
+                continue;
+              }
+              default:
+                if (isdigit((unsigned char)*(p + 1))) { // Capture results (%0-%9)
+                  s = match_capture(s, (unsigned char)*(p + 1));
+                  if (s == nullptr) {
+                    return nullptr;
+                  }
+                  p += 2;
+                  continue;
+                }
+                break; // A class, handled below
+            }
+            break;
+          case '\0': // End of pattern
+            return s; // Match succeeded
+          case '$':
+            if (*(p + 1) == '\0') { // Is the `$` the last char in pattern?
+              return s == src_end ? s : nullptr; // Check end of string
+            }
+            break;
+          default:
+            break;
+        }
+
+        const char *ep = classEnd(p); // Points to what is next
+        int m = s < src_end && singlematch((unsigned char)*s, p, ep);
+        switch (*ep) {
+          case '?': { // Optional
+            const char *res;
+            if (m && (res = match(s + 1, ep + 1)) != nullptr) {
+              return res;
+            }
+            p = ep + 1;
+            continue;
+          }
+          case '*': // 0 or more repetitions
+            return max_expand(s, p, ep);
+          case '+': // 1 or more repetitions
+            return m ? max_expand(s + 1, p, ep) : nullptr;
+          case '-': // 0 or more repetitions (minimum)
+            return min_expand(s, p, ep);
+          default:
+            if (!m) {
+              return nullptr;
+            }
+            s++;
+            p = ep;
+            continue;
+        }
+      }
+    }
+};
+
+#endif
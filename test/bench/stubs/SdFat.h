@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+typedef uint8_t oflag_t;
+#define O_READ 0x01
+#define O_RDONLY 0x01
+#define O_WRITE 0x02
+#define O_WRONLY 0x02
+#define O_RDWR 0x03
+#define O_CREAT 0x10
+#define O_TRUNC 0x20
+#define O_APPEND 0x40
+#define FILE_WRITE (O_RDWR | O_CREAT | O_APPEND)
+typedef struct { uint8_t name[11]; uint8_t attributes; uint8_t reserved; uint8_t ctime_ms; uint16_t creationTime; uint16_t creationDate; uint16_t lastAccessDate; uint16_t firstClusterHigh; uint16_t lastWriteTime; uint16_t lastWriteDate; uint16_t firstClusterLow; uint32_t fileSize; } dir_t;
+class FatVolume {};
+class FatFile : public Stream {
+public:
+  bool openRoot(FatVolume *);
+  FatFile(); FatFile(const char *, oflag_t);
+  bool open(FatFile *, const char *, oflag_t); bool open(FatFile *, uint16_t, oflag_t); bool open(const char *, oflag_t = O_RDONLY);
+  bool openNext(FatFile *, oflag_t = O_RDONLY);
+  bool close(); bool isOpen() const; bool isSubDir() const; bool isHidden() const; bool isDir() const; bool isFile() const;
+  bool getName(char *, size_t); uint32_t fileSize() const; uint32_t curPosition() const; bool seekSet(uint32_t); bool seekCur(int32_t);
+  bool rewind(); uint16_t dirIndex(); bool dirEntry(dir_t *); bool exists(const char *);
+  bool remove(); bool rename(FatFile *, const char *); bool truncate(uint32_t); bool sync();
+  int read(void *, size_t); int read() override; int available() override; int peek() override;
+  size_t write(uint8_t) override; size_t write(const void *, size_t); using Print::write;
+  uint32_t firstCluster() const; int8_t readDir(dir_t *);
+  operator bool() const;
+};
+class File : public FatFile { public: using FatFile::FatFile; };
+class SdFat : public FatVolume {
+public:
+  bool begin(uint8_t); bool exists(const char *); File open(const char *, oflag_t = O_READ); bool remove(const char *); bool rename(const char *, const char *);
+  bool mkdir(const char *); void cacheClear(); FatFile *vwd();
+};
+#define DIR_ATT_HIDDEN 0x02
+#define DIR_ATT_DIRECTORY 0x10
+static inline bool DIR_IS_FILE(const dir_t *d) { return !(d->attributes & DIR_ATT_DIRECTORY); }
+static inline bool DIR_IS_HIDDEN(const dir_t *d) { return d->attributes & DIR_ATT_HIDDEN; }
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+#define E2END 0xFFF
+int eeprom_is_ready(); uint8_t eeprom_read_byte(const uint8_t*); void eeprom_write_byte(uint8_t*, uint8_t); void eeprom_update_byte(uint8_t*, uint8_t);
+void eeprom_read_block(void*, const void*, size_t);
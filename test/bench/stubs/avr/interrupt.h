@@ -0,0 +1,4 @@
+#pragma once
+#define ISR(v) extern "C" void v(void)
+inline void cli() {} inline void sei() {}
+extern volatile uint8_t SREG;
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+extern volatile uint8_t UCSR2A, UCSR2B, UCSR2C, UDR2, UBRR2H, UBRR2L; extern volatile uint16_t UBRR2;
+#define U2X2 1
+#define RXEN2 4
+#define TXEN2 3
+#define RXCIE2 7
+#define UDRIE2 5
+#define UDRE2 5
+#define TXC2 6
+#define UCSZ20 1
+#define UCSZ21 2
+#define DOR2 3
+#define FE2 4
+#define F_CPU 16000000UL
+#define _BV(b) (1 << (b))
+#define bit_is_set(r,b) ((r) & _BV(b))
+#define UPE2 2
+#define SREG_I 7
+#define bit_is_clear(r,b) (!((r) & _BV(b)))
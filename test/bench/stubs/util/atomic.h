@@ -0,0 +1,3 @@
+#pragma once
+#define ATOMIC_BLOCK(x) for (int _i = 0; _i < 1; _i++)
+#define ATOMIC_RESTORESTATE 0
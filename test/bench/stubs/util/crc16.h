@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (int i = 0; i < 8; i++) crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+}
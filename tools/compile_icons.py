@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Pack the icons on an SD card into the throttle's RGB565 icon atlas.
+
+Converts every 24bit /icons/<name>.bmp to RGB565 and writes them to /icons.atl,
+run length encoded where that's smaller. The throttle draws icons from the atlas
+and falls back to the BMP for any that aren't in it, so run it again after adding
+or changing an icon.
+
+    python3 tools/compile_icons.py /path/to/sd
+"""
+
+import struct
+import sys
+from pathlib import Path
+
+VERSION = 1
+MAX_SIZE = 30 # Icon width and height
+RLE = 0x01
+HEADER_SIZE = 8
+ENTRY_SIZE = 12
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+
+def name_hash(name):
+    """Hash an icon name, see `IconAtlas::hash`"""
+    hash = FNV_BASIS
+    for byte in name.lower().encode('utf-8')[:31]:
+        hash = ((hash ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return hash if hash != 0 else 1 # 0 marks an unused slot
+
+
+def read_bmp(path):
+    """Read a 24bit BMP, returns width, height and RGB565 pixels top to bottom"""
+    data = path.read_bytes()
+    if data[:2] != b'BM':
+        raise ValueError('not a BMP')
+    offset, = struct.unpack_from('<I', data, 10)
+    width, height, planes, depth, compression = struct.unpack_from('<iiHHI', data, 18)
+    if depth != 24 or compression != 0:
+        raise ValueError('not a 24bit uncompressed BMP')
+
+    top_down = height < 0
+    height = abs(height)
+    if width > MAX_SIZE or height > MAX_SIZE:
+        raise ValueError('%dx%d is bigger than %dx%d' % (width, height, MAX_SIZE, MAX_SIZE))
+
+    stride = (width * 3 + 3) & ~3 # Rows are padded to 4 bytes
+    pixels = []
+    for y in range(height):
+        row = offset + (y if top_down else height - 1 - y) * stride
+        for x in range(width):
+            b, g, r = data[row + x * 3:row + x * 3 + 3]
+            pixels.append(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+    return width, height, pixels
+
+
+def encode(pixels):
+    """Raw or run length encoded pixels, whichever is smaller, see `IconAtlas::draw`"""
+    raw = struct.pack('<%dH' % len(pixels), *pixels)
+    runs = bytearray()
+    i = 0
+    while i < len(pixels):
+        count = 1
+        while i + count < len(pixels) and count < 256 and pixels[i + count] == pixels[i]:
+            count += 1
+        runs += struct.pack('<BH', count - 1, pixels[i])
+        i += count
+    return (bytes(runs), RLE) if len(runs) < len(raw) else (raw, 0)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip())
+        return 2
+
+    sd = Path(sys.argv[1])
+    icons = {}
+    failed = 0
+    for path in sorted((sd / 'icons').glob('*.bmp')):
+        try:
+            width, height, pixels = read_bmp(path)
+        except (OSError, ValueError, struct.error) as error:
+            failed += 1
+            print('%s: %s' % (path.name, error), file=sys.stderr)
+            continue
+        hash = name_hash(path.stem)
+        if hash in icons:
+            failed += 1
+            print('%s: name hash clashes with %s, rename one of them' % (path.name, icons[hash][0]), file=sys.stderr)
+            continue
+        icons[hash] = (path.name, width, height) + encode(pixels)
+
+    # The table is sorted by hash so the throttle can binary search it
+    table = bytearray()
+    data = bytearray()
+    offset = HEADER_SIZE + len(icons) * ENTRY_SIZE
+    for hash in sorted(icons):
+        name, width, height, pixels, flags = icons[hash]
+        table += struct.pack('<IIBBBx', hash, offset + len(data), width, height, flags)
+        data += pixels
+
+    header = struct.pack('<4sBxH', b'ICNA', VERSION, len(icons))
+    (sd / 'icons.atl').write_bytes(header + table + data)
+
+    print('Packed %d of %d icons, %d bytes' % (len(icons), len(icons) + failed, HEADER_SIZE + len(table) + len(data)))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
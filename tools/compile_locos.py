@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Compile the loco JSON configs on an SD card into the throttle's binary format.
+
+Writes /cfg/<address>.bin for every /locos/<address>.json, the same files the
+throttle writes itself the first time it opens a loco, so it can read them
+straight away. Run it against the mounted SD card rather than a copy, a config
+is recompiled on the throttle if its modified time or size don't match.
+
+    python3 tools/compile_locos.py /path/to/sd
+"""
+
+import json
+import struct
+import sys
+import time
+from pathlib import Path
+
+VERSION = 1
+NAME_SIZE = 32 # Including the terminator
+FUNCTIONS_SIZE = 20 # Including the terminator
+MAX_SIZE = 4096 + NAME_SIZE # Largest packed block the throttle reads, its JSON arena plus the name
+
+# Packed function field flags
+IDLE_FILL = 0x01
+LABEL = 0x10
+LATCHING = 0x80
+
+# Default colours, idle fill & text then pressed fill & text
+DEFAULT_COLOURS = (0x0000, 0xFFFF, 0xFFFF, 0x0000)
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+
+def fnv1a(hash, data):
+    for byte in data:
+        hash = ((hash ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return hash
+
+
+def stamp(hash, path):
+    """Hash a file's FAT modified date, time and size, zeros if it's missing"""
+    date = fat_time = size = 0
+    if path.is_file():
+        stat = path.stat()
+        t = time.localtime(stat.st_mtime)
+        date = ((t.tm_year - 1980) << 9) | (t.tm_mon << 5) | t.tm_mday
+        fat_time = (t.tm_hour << 11) | (t.tm_min << 5) | (t.tm_sec // 2)
+        size = stat.st_size
+    return fnv1a(hash, struct.pack('<HHI', date, fat_time, size))
+
+
+def string(value):
+    return value if isinstance(value, str) else None
+
+
+def c_string(value, size):
+    """Encode and truncate like strlcpy into a buffer of size"""
+    return value.encode('utf-8')[:size - 1]
+
+
+def default_functions():
+    return [[{'label': 'F%d' % fn, 'fn': fn} for fn in range(row, min(row + 3, 29))] for row in range(0, 29, 3)]
+
+
+def pack(rows, name):
+    """Pack function rows and a name, see `LocoProfile::pack`"""
+    rows = [row if isinstance(row, list) else [] for row in rows]
+    data = bytearray([len(rows) & 0xFF])
+    data += bytes(len(row) & 0xFF for row in rows)
+
+    for row in rows:
+        for fn in row:
+            fn = fn if isinstance(fn, dict) else {}
+            btn = fn.get('btn') if isinstance(fn.get('btn'), dict) else {}
+            idle = btn.get('idle') if isinstance(btn.get('idle'), dict) else {}
+            pressed = btn.get('pressed') if isinstance(btn.get('pressed'), dict) else {}
+            colours = [idle.get('fill'), idle.get('text'), pressed.get('fill'), pressed.get('text')]
+            strings = [string(fn.get('label')), string(idle.get('icon')), string(pressed.get('icon'))]
+
+            fields = 0
+            for i, colour in enumerate(colours):
+                if colour is not None:
+                    fields |= IDLE_FILL << i
+            for i, value in enumerate(strings):
+                if value is not None:
+                    fields |= LABEL << i
+
+            number = fn.get('fn')
+            number = number if isinstance(number, int) and not isinstance(number, bool) else 0
+            latching = fn.get('latching')
+            latching = latching if isinstance(latching, bool) else True
+            data.append((number | (LATCHING if latching else 0)) & 0xFF)
+            data.append(fields)
+            for colour in colours:
+                if colour is not None:
+                    colour = int(colour) if isinstance(colour, (int, float)) and not isinstance(colour, bool) else 0
+                    data += struct.pack('<H', colour & 0xFFFF)
+            for value in strings:
+                if value is not None:
+                    data += value.encode('utf-8') + b'\0'
+
+    layout_size = len(data)
+    data += c_string(name, NAME_SIZE) + b'\0'
+    return data, layout_size
+
+
+def compile_loco(sd, config):
+    """Compile a loco config, returns an error message or None"""
+    address = int(config.stem)
+    try:
+        doc = json.loads(config.read_text(encoding='utf-8'))
+    except ValueError as error:
+        return 'invalid JSON, %s' % error
+    doc = doc if isinstance(doc, dict) else {}
+
+    name = string(doc.get('name')) or ''
+    functions = doc.get('functions')
+    map_name = string(functions) or ''
+    if len(map_name.encode('utf-8')) >= FUNCTIONS_SIZE:
+        return 'function map name is too long to compile, the throttle will parse it each time'
+
+    rows = functions if isinstance(functions, list) else []
+    if map_name:
+        try:
+            rows = json.loads((sd / 'fns' / (map_name + '.json')).read_text(encoding='utf-8'))
+        except (OSError, ValueError) as error:
+            return 'function map %s, %s' % (map_name, error)
+        rows = rows if isinstance(rows, list) else []
+    if len(rows) == 0:
+        rows = default_functions()
+
+    data, layout_size = pack(rows, name)
+    if len(data) > MAX_SIZE:
+        return 'compiles to %d bytes, more than the throttle reads (%d)' % (len(data), MAX_SIZE)
+    signature = stamp(FNV_BASIS, sd / 'locos' / ('%d.json' % address))
+    if map_name:
+        signature = stamp(signature, sd / 'fns' / (map_name + '.json'))
+
+    header = struct.pack('<3sBHHI%ds' % FUNCTIONS_SIZE, b'LCB', VERSION, len(data), layout_size, signature,
+                         map_name.encode('utf-8'))
+    (sd / 'cfg').mkdir(exist_ok=True)
+    (sd / 'cfg' / ('%d.bin' % address)).write_bytes(header + data)
+    return None
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip())
+        return 2
+
+    sd = Path(sys.argv[1])
+    configs = sorted(path for path in (sd / 'locos').glob('*.json')
+                     if path.stem.isdigit() and str(int(path.stem)) == path.stem)
+    failed = 0
+    for config in configs:
+        error = compile_loco(sd, config)
+        if error:
+            failed += 1
+            print('%s: %s' % (config.name, error), file=sys.stderr)
+
+    print('Compiled %d of %d loco configs' % (len(configs) - failed, len(configs)))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())